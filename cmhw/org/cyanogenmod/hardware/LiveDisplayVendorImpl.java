@@ -35,9 +35,78 @@ public class LiveDisplayVendorImpl {
     public static final int ADAPTIVE_BACKLIGHT = 0x8;
     public static final int PICTURE_ADJUSTMENT = 0x10;
 
+    // Indices into native_getState(), floats are stored as raw int bits
+    public static final int STATE_FEATURES = 0;
+    public static final int STATE_MODE_ID = 1;
+    public static final int STATE_COLOR_BALANCE = 2;
+    public static final int STATE_COLOR_TEMPERATURE = 3;
+    public static final int STATE_HUE = 4;
+    public static final int STATE_SATURATION = 5;
+    public static final int STATE_INTENSITY = 6;
+    public static final int STATE_CONTRAST = 7;
+    public static final int STATE_SATURATION_THRESHOLD = 8;
+    public static final int STATE_OUTDOOR_MODE = 9;
+    public static final int STATE_ADAPTIVE_BACKLIGHT = 10;
+
+    // Indices into native_getStats()
+    public static final int STAT_PLANS = 0;
+    public static final int STAT_LAST_PLAN_SIZE = 1;
+    public static final int STAT_PLAN_OPS = 2;
+    public static final int STAT_SKIPPED_OPS = 3;
+    public static final int STAT_PROFILE_SWITCHES = 4;
+    public static final int STAT_LAST_PROFILE_LATENCY_US = 5;
+    public static final int STAT_MAX_PROFILE_LATENCY_US = 6;
+    public static final int STAT_DEFERRED_SETTINGS = 7;
+    public static final int STAT_DEFERRED_COMMITS = 8;
+    public static final int STAT_RETRIES = 9;
+    public static final int STAT_RECONNECTS = 10;
+    public static final int STAT_RESETS = 11;
+    public static final int STAT_BACKOFF_SKIPS = 12;
+    public static final int STAT_LAST_PROBE_US = 13;
+
+    // Indices into native_getClientStats()
+    public static final int CLIENT_STAT_REQUESTS = 0;
+    public static final int CLIENT_STAT_CHANGES = 1;
+    public static final int CLIENT_STAT_OPS = 2;
+    public static final int CLIENT_STAT_OWNED = 3;
+
+    // Indices into native_getHealth()
+    public static final int HEALTH_DEGRADED = 0;
+    public static final int HEALTH_HUNG_CALLS = 1;
+    public static final int HEALTH_REJECTED_CALLS = 2;
+    public static final int HEALTH_RECOVERIES = 3;
+    public static final int HEALTH_CURRENT_HANG_MS = 4;
+    public static final int HEALTH_LAST_HANG_MS = 5;
+    public static final int HEALTH_MAX_HANG_MS = 6;
+
+    // Layout of the arrays filled by native_getRanges
+    private static final int INT_RANGE_COLOR_BALANCE = 0;
+    private static final int INT_RANGE_COLOR_TEMPERATURE = 3;
+    private static final int INT_RANGE_HUE = 6;
+    private static final int INT_RANGES_SIZE = 9;
+
+    private static final int FLOAT_RANGE_SATURATION = 0;
+    private static final int FLOAT_RANGE_INTENSITY = 3;
+    private static final int FLOAT_RANGE_CONTRAST = 6;
+    private static final int FLOAT_RANGE_SATURATION_THRESHOLD = 9;
+    private static final int FLOAT_RANGES_SIZE = 12;
+
+    private static final int HSIC_SIZE = 5;
+
     private static boolean sNativeLibraryLoaded;
     private static int     sFeatures;
 
+    // Ranges can't change once the backend is up, so each feature's ranges
+    // are fetched until the backend returns them once
+    private static int            sRangesLoaded;
+    private static Range<Integer> sColorBalanceRange;
+    private static Range<Integer> sColorTemperatureRange;
+    private static Range<Float>   sHueRange;
+    private static Range<Float>   sSaturationRange;
+    private static Range<Float>   sIntensityRange;
+    private static Range<Float>   sContrastRange;
+    private static Range<Float>   sSaturationThresholdRange;
+
     static {
         try {
             System.loadLibrary("jni_livedisplay");
@@ -65,6 +134,7 @@ public class LiveDisplayVendorImpl {
     public static native DisplayMode native_getCurrentDisplayMode();
     public static native DisplayMode native_getDefaultDisplayMode();
     public static native boolean native_setDisplayMode(DisplayMode mode, boolean makeDefault);
+    public static native boolean native_setDisplayModeById(int id, boolean makeDefault);
 
     public static native boolean native_setAdaptiveBacklightEnabled(boolean enabled);
     public static native boolean native_isAdaptiveBacklightEnabled();
@@ -72,17 +142,188 @@ public class LiveDisplayVendorImpl {
     public static native boolean native_setOutdoorModeEnabled(boolean enabled);
     public static native boolean native_isOutdoorModeEnabled();
 
-    public static native Range<Integer> native_getColorBalanceRange();
     public static native int native_getColorBalance();
     public static native boolean native_setColorBalance(int value);
 
-    public static native boolean native_setPictureAdjustment(final HSIC hsic);
-    public static native HSIC native_getPictureAdjustment();
-    public static native HSIC native_getDefaultPictureAdjustment();
+    public static native int native_getColorTemperature();
+    public static native boolean native_setColorTemperature(int kelvin);
+
+    /**
+     * Lock free reads of the last known values, which never reach the
+     * backend. Booleans are returned as 0 or 1, and PEEK_UNKNOWN is
+     * returned until a value is known. The natives take no env or class,
+     * so these can become @CriticalNative on platforms which have it.
+     */
+    public static final int PEEK_UNKNOWN = Integer.MIN_VALUE;
+
+    public static native int native_peekSupportedFeatures();
+    public static native int native_peekColorBalance();
+    public static native int native_peekColorTemperature();
+    public static native int native_peekOutdoorMode();
+    public static native int native_peekAdaptiveBacklight();
+
+    /**
+     * Fills intRanges and floatRanges with every range in one call, and
+     * returns the features whose ranges are valid.
+     */
+    private static native int native_getRanges(int[] intRanges, float[] floatRanges);
+
+    private static native boolean native_setPictureAdjustmentValues(float[] hsic);
+    private static native boolean native_getPictureAdjustmentValues(float[] hsic);
+    private static native boolean native_getDefaultPictureAdjustmentValues(float[] hsic);
+
+    private static synchronized void loadRanges() {
+        final int wanted = sFeatures & (COLOR_BALANCE | PICTURE_ADJUSTMENT);
+        if ((sRangesLoaded & wanted) == wanted) {
+            return;
+        }
+
+        final int[] ints = new int[INT_RANGES_SIZE];
+        final float[] floats = new float[FLOAT_RANGES_SIZE];
+        final int valid = native_getRanges(ints, floats) & wanted & ~sRangesLoaded;
+        if (valid == 0) {
+            return;
+        }
+
+        if ((valid & COLOR_BALANCE) != 0) {
+            sColorBalanceRange = intRange(ints, INT_RANGE_COLOR_BALANCE);
+            if (ints[INT_RANGE_COLOR_TEMPERATURE + 1] > 0) {
+                sColorTemperatureRange = intRange(ints, INT_RANGE_COLOR_TEMPERATURE);
+            }
+        }
+        if ((valid & PICTURE_ADJUSTMENT) != 0) {
+            sHueRange = new Range<Float>((float) ints[INT_RANGE_HUE],
+                    (float) ints[INT_RANGE_HUE + 1]);
+            sSaturationRange = floatRange(floats, FLOAT_RANGE_SATURATION);
+            sIntensityRange = floatRange(floats, FLOAT_RANGE_INTENSITY);
+            sContrastRange = floatRange(floats, FLOAT_RANGE_CONTRAST);
+            sSaturationThresholdRange = floatRange(floats, FLOAT_RANGE_SATURATION_THRESHOLD);
+        }
+        sRangesLoaded |= valid;
+    }
+
+    private static Range<Integer> intRange(int[] ranges, int offset) {
+        return new Range<Integer>(ranges[offset], ranges[offset + 1]);
+    }
+
+    private static Range<Float> floatRange(float[] ranges, int offset) {
+        return new Range<Float>(ranges[offset], ranges[offset + 1]);
+    }
+
+    private static HSIC toHSIC(float[] values) {
+        return new HSIC(values[0], values[1], values[2], values[3], values[4]);
+    }
+
+    public static Range<Integer> native_getColorBalanceRange() {
+        loadRanges();
+        return sColorBalanceRange;
+    }
+
+    public static Range<Integer> native_getColorTemperatureRange() {
+        loadRanges();
+        return sColorTemperatureRange;
+    }
+
+    public static boolean native_setPictureAdjustment(final HSIC hsic) {
+        return native_setPictureAdjustmentValues(new float[] {
+                hsic.getHue(), hsic.getSaturation(), hsic.getIntensity(),
+                hsic.getContrast(), hsic.getSaturationThreshold() });
+    }
+
+    public static HSIC native_getPictureAdjustment() {
+        final float[] values = new float[HSIC_SIZE];
+        return native_getPictureAdjustmentValues(values) ? toHSIC(values) : null;
+    }
+
+    public static HSIC native_getDefaultPictureAdjustment() {
+        final float[] values = new float[HSIC_SIZE];
+        return native_getDefaultPictureAdjustmentValues(values) ? toHSIC(values) : null;
+    }
+
+    public static Range<Float> native_getHueRange() {
+        loadRanges();
+        return sHueRange;
+    }
+
+    public static Range<Float> native_getSaturationRange() {
+        loadRanges();
+        return sSaturationRange;
+    }
+
+    public static Range<Float> native_getIntensityRange() {
+        loadRanges();
+        return sIntensityRange;
+    }
+
+    public static Range<Float> native_getContrastRange() {
+        loadRanges();
+        return sContrastRange;
+    }
+
+    public static Range<Float> native_getSaturationThresholdRange() {
+        loadRanges();
+        return sSaturationThresholdRange;
+    }
+
+    /**
+     * Applies the settings flagged in features in one go, skipping the ones
+     * already in place. Nothing is persisted.
+     */
+    public static native boolean native_applyState(int features, DisplayMode mode,
+            int colorBalance, HSIC hsic, boolean outdoorMode, boolean adaptiveBacklight);
+
+    /**
+     * Registers a display profile which can later be switched to with a
+     * single call. Only the settings flagged in features are part of it.
+     */
+    public static native boolean native_setProfile(int id, int features, DisplayMode mode,
+            int colorBalance, HSIC hsic, boolean outdoorMode, boolean adaptiveBacklight);
+    public static native boolean native_removeProfile(int id);
+    public static native boolean native_applyProfile(int id);
+
+    /**
+     * Sets the settings a client wants, flagged in features. Where clients
+     * disagree, the one with the highest priority wins. The user's own
+     * settings rank below every client.
+     */
+    public static native boolean native_setClientLayer(int client, int priority, int features,
+            DisplayMode mode, int colorBalance, HSIC hsic, boolean outdoorMode,
+            boolean adaptiveBacklight);
+    public static native boolean native_removeClientLayer(int client);
+    public static native int[] native_getClientStats(int client);
+
+    /**
+     * Returns every setting read from one consistent snapshot, or null if
+     * the backend is unavailable. STATE_FEATURES flags the valid entries.
+     */
+    public static native int[] native_getState();
+
+    /**
+     * Same layout as native_getState(), but read from the state published
+     * by the process driving the display. Doesn't touch the backend, so
+     * it is cheap and never blocks. The color temperature is not included.
+     */
+    public static native int[] native_getPublishedState();
+
+    public static HSIC getPictureAdjustment(int[] state) {
+        return new HSIC((float) state[STATE_HUE],
+                Float.intBitsToFloat(state[STATE_SATURATION]),
+                Float.intBitsToFloat(state[STATE_INTENSITY]),
+                Float.intBitsToFloat(state[STATE_CONTRAST]),
+                Float.intBitsToFloat(state[STATE_SATURATION_THRESHOLD]));
+    }
+
+    /**
+     * While the screen is off, settings are only recorded and are applied
+     * together once it turns back on.
+     */
+    public static native boolean native_setScreenOn(boolean on);
+
+    public static native int[] native_getStats();
 
-    public static native Range<Float> native_getHueRange();
-    public static native Range<Float> native_getSaturationRange();
-    public static native Range<Float> native_getIntensityRange();
-    public static native Range<Float> native_getContrastRange();
-    public static native Range<Float> native_getSaturationThresholdRange();
+    /**
+     * Backend calls which miss their deadline fail with a timeout and
+     * leave the backend degraded until the stuck call returns.
+     */
+    public static native int[] native_getHealth();
 }
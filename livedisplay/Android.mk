@@ -19,18 +19,78 @@ LOCAL_SHARED_LIBRARIES := \
     libutils
 
 LOCAL_SRC_FILES := \
+    src/ColorPipeline.cpp \
+    src/ColorTemperature.cpp \
+    src/DisplayPlan.cpp \
+    src/GammaLut.cpp \
     src/LiveDisplay.cpp \
+    src/LiveDisplayServer.cpp \
+    src/ProfileStore.cpp \
+    src/SettingArbiter.cpp \
     impl/Utils.cpp \
+    impl/BackendExecutor.cpp \
+    impl/ChainedBackend.cpp \
     impl/LegacyMM.cpp \
-    impl/SDM.cpp
+    impl/PlatformBackend.cpp \
+    impl/SDM.cpp \
+    impl/SettingsStore.cpp \
+    impl/StatePage.cpp \
+    impl/SysfsBackend.cpp \
+    impl/VendorLibrary.cpp
 
 LOCAL_MODULE_TAGS := optional
 LOCAL_MODULE := liblivedisplay
 LOCAL_CFLAGS := -std=c++11
+LOCAL_ARM_NEON := true
 
 include $(BUILD_STATIC_LIBRARY)
 
 
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(common_C_INCLUDES)
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils
+
+LOCAL_SRC_FILES := \
+    src/LiveDisplayClient.cpp \
+    src/LiveDisplayProtocol.cpp \
+    impl/RemoteBackend.cpp
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := liblivedisplay_client
+LOCAL_CFLAGS := -std=c++11
+
+include $(BUILD_STATIC_LIBRARY)
+
+
+# Owns the vendor backend, libjni_livedisplay reaches it through RemoteBackend
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    daemon/livedisplayd.cpp
+
+LOCAL_C_INCLUDES := $(common_C_INCLUDES)
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    liblog \
+    libutils
+
+LOCAL_STATIC_LIBRARIES := \
+    liblivedisplay \
+    liblivedisplay_client
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := livedisplayd
+LOCAL_INIT_RC := daemon/livedisplayd.rc
+LOCAL_CFLAGS := -std=c++11
+
+include $(BUILD_EXECUTABLE)
+
+
 include $(CLEAR_VARS)
 LOCAL_SRC_FILES	:= \
     jni/org_cyanogenmod_hardware_LiveDisplayVendorImpl.cpp
@@ -43,7 +103,9 @@ LOCAL_SHARED_LIBRARIES := \
     libnativehelper \
     libutils
 
-LOCAL_STATIC_LIBRARIES := liblivedisplay
+LOCAL_STATIC_LIBRARIES := \
+    liblivedisplay \
+    liblivedisplay_client
 
 LOCAL_MODULE_TAGS := optional
 LOCAL_MODULE := libjni_livedisplay
@@ -51,4 +113,6 @@ LOCAL_CFLAGS := -std=c++11
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif
@@ -0,0 +1,53 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "livedisplayd"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <cutils/sockets.h>
+#include <utils/Log.h>
+
+#include "LiveDisplayServer.h"
+#include "PlatformBackend.h"
+
+using namespace android;
+
+int main() {
+    int fd = android_get_control_socket(LIVEDISPLAY_SOCKET);
+    if (fd < 0) {
+        ALOGE("No control socket, not started by init?");
+        return 1;
+    }
+    if (listen(fd, 8) < 0) {
+        ALOGE("listen failed: %s", strerror(errno));
+        return 1;
+    }
+
+    // The only process holding a backend connection, LiveDisplay in
+    // system_server reaches it through RemoteBackend
+    LiveDisplayBackend* backend = createPlatformBackend();
+    if (backend == NULL) {
+        ALOGE("No LiveDisplay backend on this device");
+        return 1;
+    }
+
+    LiveDisplayServer server(*backend);
+    return server.run(fd) == OK ? 0 : 1;
+}
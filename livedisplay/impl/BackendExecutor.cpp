@@ -0,0 +1,129 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Executor"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "BackendExecutor.h"
+
+namespace android {
+
+BackendExecutor::~BackendExecutor() {
+    {
+        Mutex::Autolock _l(mLock);
+        mExiting = true;
+        mWork.signal();
+    }
+    if (!mWorker.joinable()) {
+        return;
+    }
+    if (mHung) {
+        // Can't wait for a vendor call which may never return
+        mWorker.detach();
+    } else {
+        mWorker.join();
+    }
+}
+
+status_t BackendExecutor::run(const std::function<status_t()>& op, nsecs_t timeout) {
+    Mutex::Autolock _l(mLock);
+
+    if (mTask != NULL) {
+        mHealth.rejectedCalls++;
+        return TIMED_OUT;
+    }
+    if (!mWorker.joinable()) {
+        mWorker = std::thread(&BackendExecutor::loop, this);
+    }
+
+    std::shared_ptr<Task> task = std::make_shared<Task>(op);
+    mTask = task;
+    mWork.signal();
+
+    nsecs_t deadline = systemTime() + timeout;
+    while (!task->done) {
+        nsecs_t now = systemTime();
+        if (now >= deadline) {
+            if (!task->started) {
+                // Never picked up, so it's safe to drop
+                mTask.reset();
+                return TIMED_OUT;
+            }
+            if (!mHung) {
+                mHung = true;
+                mHealth.degraded = true;
+                mHealth.hungCalls++;
+                ALOGE("Backend call stuck for %" PRId64 "ms", ns2ms(now - mStarted));
+            }
+            return TIMED_OUT;
+        }
+        mDone.waitRelative(mLock, deadline - now);
+    }
+    return task->result;
+}
+
+void BackendExecutor::loop() {
+    mLock.lock();
+    while (!mExiting) {
+        if (mTask == NULL || mTask->started) {
+            mWork.wait(mLock);
+            continue;
+        }
+
+        std::shared_ptr<Task> task = mTask;
+        task->started = true;
+        mStarted = systemTime();
+        mLock.unlock();
+
+        status_t rc = task->op();
+
+        mLock.lock();
+        task->result = rc;
+        task->done = true;
+        mTask.reset();
+
+        if (mHung) {
+            uint32_t ms = (uint32_t)ns2ms(systemTime() - mStarted);
+            mHung = false;
+            mRecoveries++;
+            mHealth.degraded = false;
+            mHealth.recoveries++;
+            mHealth.lastHangMs = ms;
+            mHealth.maxHangMs = std::max(mHealth.maxHangMs, ms);
+            ALOGW("Stuck backend call returned after %ums", ms);
+        }
+        mDone.broadcast();
+    }
+    mLock.unlock();
+}
+
+void BackendExecutor::getHealth(BackendHealth& health) {
+    Mutex::Autolock _l(mLock);
+    health = mHealth;
+    health.currentHangMs = mHung ? (uint32_t)ns2ms(systemTime() - mStarted) : 0;
+}
+
+uint32_t BackendExecutor::recoveries() {
+    Mutex::Autolock _l(mLock);
+    return mRecoveries;
+}
+};
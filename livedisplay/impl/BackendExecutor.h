@@ -0,0 +1,86 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_BACKENDEXECUTOR_H
+#define CYNGN_BACKENDEXECUTOR_H
+
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include <utils/Condition.h>
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+
+#include "Types.h"
+
+namespace android {
+
+/*
+ * Runs backend calls on a worker thread so a vendor call that never
+ * returns can't hold up its caller. A call that misses its deadline
+ * fails with TIMED_OUT and leaves the executor degraded. Until the
+ * stuck call returns, every other call is refused straight away, so
+ * the backend is still only entered by one thread at a time.
+ *
+ * A call may finish after its caller has given up on it, so it must not
+ * refer to anything on the caller's stack except its inputs.
+ */
+class BackendExecutor {
+  public:
+    BackendExecutor() : mExiting(false), mHung(false), mStarted(0), mRecoveries(0) {
+    }
+    ~BackendExecutor();
+
+    status_t run(const std::function<status_t()>& op, nsecs_t timeout);
+
+    void getHealth(BackendHealth& health);
+
+    // Bumped every time a stuck call returns
+    uint32_t recoveries();
+
+  private:
+    class Task {
+      public:
+        explicit Task(const std::function<status_t()>& _op)
+            : op(_op), result(OK), started(false), done(false) {
+        }
+
+        std::function<status_t()> op;
+        status_t result;
+        bool started;
+        bool done;
+    };
+
+    void loop();
+
+    std::shared_ptr<Task> mTask;
+    bool mExiting;
+    bool mHung;
+    nsecs_t mStarted;
+    uint32_t mRecoveries;
+    BackendHealth mHealth;
+
+    std::thread mWorker;
+    Condition mWork;
+    Condition mDone;
+    Mutex mLock;
+};
+};
+
+#endif
@@ -0,0 +1,82 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Chain"
+#include <utils/Log.h>
+
+#include "ChainedBackend.h"
+
+namespace android {
+
+ChainedBackend::~ChainedBackend() {
+    delete mPrimary;
+    delete mSecondary;
+}
+
+/*
+ * Fails only if both backends do, so the secondary still works on a
+ * device whose vendor library is missing or broken. Until the platform
+ * backend comes up, its features just aren't probed. Once it has been
+ * up, it has to come back: a reconnect keeps routing its features to it.
+ */
+status_t ChainedBackend::initialize() {
+    status_t rc = mPrimary->initialize();
+    mPrimaryReady = rc == OK;
+    mSecondaryReady = mSecondary->initialize() == OK;
+
+    if (mPrimaryReady) {
+        mPrimaryWasReady = true;
+    } else if (mPrimaryWasReady) {
+        ALOGE("Platform backend failed to come back (%d)", rc);
+        if (mSecondaryReady) {
+            mSecondary->deinitialize();
+            mSecondaryReady = false;
+        }
+        return rc;
+    }
+
+    if (!mPrimaryReady && mSecondaryReady) {
+        ALOGE("Platform backend failed to initialize (%d), continuing without it", rc);
+        return OK;
+    }
+    return rc;
+}
+
+status_t ChainedBackend::deinitialize() {
+    if (mPrimaryReady) {
+        mPrimary->deinitialize();
+        mPrimaryReady = false;
+    }
+    if (mSecondaryReady) {
+        mSecondary->deinitialize();
+        mSecondaryReady = false;
+    }
+    return OK;
+}
+
+bool ChainedBackend::hasFeature(Feature feature) {
+    if (mPrimaryReady && mPrimary->hasFeature(feature)) {
+        mSecondaryFeatures &= ~(uint32_t)feature;
+        return true;
+    }
+    if (mSecondaryReady && mSecondary->hasFeature(feature)) {
+        mSecondaryFeatures |= (uint32_t)feature;
+        return true;
+    }
+    return false;
+}
+};
@@ -0,0 +1,139 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_CHAINEDBACKEND_H
+#define CYNGN_CHAINEDBACKEND_H
+
+#include <atomic>
+
+#include <LiveDisplayBackend.h>
+
+namespace android {
+
+/*
+ * Puts a second backend behind the platform one, for the features the
+ * platform backend doesn't have. Each feature goes to whichever backend
+ * claimed it in the last probe, the primary first. Both backends are
+ * owned by the chain.
+ */
+class ChainedBackend : public LiveDisplayBackend {
+  public:
+    ChainedBackend(LiveDisplayBackend* primary, LiveDisplayBackend* secondary)
+        : mPrimary(primary),
+          mSecondary(secondary),
+          mPrimaryReady(false),
+          mPrimaryWasReady(false),
+          mSecondaryReady(false),
+          mSecondaryFeatures(0) {
+    }
+    virtual ~ChainedBackend();
+
+    virtual status_t initialize();
+    virtual status_t deinitialize();
+    virtual bool hasFeature(Feature feature);
+
+    virtual bool supportsConcurrentProbe() {
+        return mPrimary->supportsConcurrentProbe() && mSecondary->supportsConcurrentProbe();
+    }
+
+    virtual status_t setAdaptiveBacklightEnabled(bool enabled) {
+        return backendFor(Feature::ADAPTIVE_BACKLIGHT)->setAdaptiveBacklightEnabled(enabled);
+    }
+    virtual bool isAdaptiveBacklightEnabled() {
+        return backendFor(Feature::ADAPTIVE_BACKLIGHT)->isAdaptiveBacklightEnabled();
+    }
+
+    virtual status_t setOutdoorModeEnabled(bool enabled) {
+        return backendFor(Feature::OUTDOOR_MODE)->setOutdoorModeEnabled(enabled);
+    }
+    virtual bool isOutdoorModeEnabled() {
+        return backendFor(Feature::OUTDOOR_MODE)->isOutdoorModeEnabled();
+    }
+
+    virtual status_t getColorBalanceRange(Range& range) {
+        return backendFor(Feature::COLOR_TEMPERATURE)->getColorBalanceRange(range);
+    }
+    virtual status_t setColorBalance(int32_t balance) {
+        return backendFor(Feature::COLOR_TEMPERATURE)->setColorBalance(balance);
+    }
+    virtual int32_t getColorBalance() {
+        return backendFor(Feature::COLOR_TEMPERATURE)->getColorBalance();
+    }
+
+    virtual status_t getColorTemperatureRange(Range& range) {
+        return backendFor(Feature::COLOR_TEMPERATURE)->getColorTemperatureRange(range);
+    }
+    virtual status_t setColorTemperature(int32_t kelvin) {
+        return backendFor(Feature::COLOR_TEMPERATURE)->setColorTemperature(kelvin);
+    }
+    virtual int32_t getColorTemperature() {
+        return backendFor(Feature::COLOR_TEMPERATURE)->getColorTemperature();
+    }
+
+    virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles) {
+        return backendFor(Feature::DISPLAY_MODES)->getDisplayModes(profiles);
+    }
+    virtual status_t getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                           size_t& count) {
+        return backendFor(Feature::DISPLAY_MODES)->getDisplayModeRecords(records, capacity,
+                                                                         count);
+    }
+    virtual status_t setDisplayMode(int32_t modeID, bool makeDefault) {
+        return backendFor(Feature::DISPLAY_MODES)->setDisplayMode(modeID, makeDefault);
+    }
+    virtual sp<DisplayMode> getCurrentDisplayMode() {
+        return backendFor(Feature::DISPLAY_MODES)->getCurrentDisplayMode();
+    }
+    virtual sp<DisplayMode> getDefaultDisplayMode() {
+        return backendFor(Feature::DISPLAY_MODES)->getDefaultDisplayMode();
+    }
+
+    virtual status_t getPictureAdjustmentRanges(HSICRanges& ranges) {
+        return backendFor(Feature::PICTURE_ADJUSTMENT)->getPictureAdjustmentRanges(ranges);
+    }
+    virtual status_t getPictureAdjustment(HSIC& hsic) {
+        return backendFor(Feature::PICTURE_ADJUSTMENT)->getPictureAdjustment(hsic);
+    }
+    virtual status_t getDefaultPictureAdjustment(HSIC& hsic) {
+        return backendFor(Feature::PICTURE_ADJUSTMENT)->getDefaultPictureAdjustment(hsic);
+    }
+    virtual status_t setPictureAdjustment(HSIC hsic) {
+        return backendFor(Feature::PICTURE_ADJUSTMENT)->setPictureAdjustment(hsic);
+    }
+
+    // Gamma tables only come from the platform
+    virtual status_t setGammaLut(const GammaLut& lut) {
+        return mPrimary->setGammaLut(lut);
+    }
+
+  private:
+    LiveDisplayBackend* backendFor(Feature feature) {
+        return (mSecondaryFeatures & feature) ? mSecondary : mPrimary;
+    }
+
+    LiveDisplayBackend* mPrimary;
+    LiveDisplayBackend* mSecondary;
+    bool mPrimaryReady;
+    bool mPrimaryWasReady;
+    bool mSecondaryReady;
+
+    // Features claimed by the secondary, probes may run concurrently
+    std::atomic<uint32_t> mSecondaryFeatures;
+};
+};
+
+#endif
@@ -15,7 +15,6 @@
 */
 
 #include <cutils/sockets.h>
-#include <dlfcn.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <signal.h>
@@ -27,96 +26,28 @@
 #include <utils/Log.h>
 
 #include "LegacyMM.h"
+#include "SettingsStore.h"
 
 namespace android {
 
 status_t LegacyMM::initialize() {
-    status_t rc = OK;
-    mLibHandle = dlopen(MM_DISP_LIB, RTLD_NOW);
-    if (mLibHandle == NULL) {
-        ALOGE("DLOPEN failed for %s", MM_DISP_LIB);
-        return NO_INIT;
+    status_t rc = mLib.open();
+    if (rc != OK) {
+        return rc;
     }
 
-    disp_api_init = (int(*)(int32_t))dlsym(mLibHandle, "disp_api_init");
-    if (disp_api_init == NULL) {
-        ALOGE("dlsym failed for disp_api_init");
-    }
-    disp_api_supported = (int(*)(int32_t, int32_t))dlsym(mLibHandle, "disp_api_supported");
-    if (disp_api_supported == NULL) {
-        ALOGE("dlsym failed for disp_api_supported");
-    }
-    disp_api_get_color_balance_range =
-        (int(*)(int32_t, void*))dlsym(mLibHandle, "disp_api_get_color_balance_range");
-    if (disp_api_get_color_balance_range == NULL) {
-        ALOGE("dlsym failed for disp_api_get_color_balance_range");
-    }
-    disp_api_set_color_balance =
-        (int(*)(int32_t, int))dlsym(mLibHandle, "disp_api_set_color_balance");
-    if (disp_api_set_color_balance == NULL) {
-        ALOGE("dlsym failed for disp_api_set_color_balance");
-    }
-    disp_api_get_color_balance =
-        (int(*)(int32_t, int*))dlsym(mLibHandle, "disp_api_get_color_balance");
-    if (disp_api_get_color_balance == NULL) {
-        ALOGE("dlsym failed for disp_api_get_color_balance");
-    }
-    disp_api_get_num_display_modes =
-        (int(*)(int32_t, int32_t, int*))dlsym(mLibHandle, "disp_api_get_num_display_modes");
-    if (disp_api_get_num_display_modes == NULL) {
-        ALOGE("dlsym failed for disp_api_get_num_display_modes");
-    }
-    disp_api_get_display_modes =(int(*)(int32_t, int32_t, void*, int))dlsym(
-        mLibHandle, "disp_api_get_display_modes");
-    if (disp_api_get_display_modes == NULL) {
-        ALOGE("dlsym failed for disp_api_get_display_modes");
-    }
-    disp_api_get_active_display_mode = (int(*)(int32_t, int*, uint32_t*))dlsym(
-        mLibHandle, "disp_api_get_active_display_mode");
-    if (disp_api_get_active_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_get_active_display_mode");
-    }
-    disp_api_set_active_display_mode =
-        (int(*)(int32_t, int))dlsym(mLibHandle, "disp_api_set_active_display_mode");
-    if (disp_api_set_active_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_set_active_display_mode");
-    }
-    disp_api_set_default_display_mode =
-        (int(*)(int32_t, int))dlsym(mLibHandle, "disp_api_set_default_display_mode");
-    if (disp_api_set_default_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_set_default_display_mode");
-    }
-    disp_api_get_default_display_mode =
-        (int(*)(int32_t, int*))dlsym(mLibHandle, "disp_api_get_default_display_mode");
-    if (disp_api_get_default_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_get_default_display_mode");
-    }
-    disp_api_get_pa_range = (int(*)(int32_t, void*))dlsym(mLibHandle, "disp_api_get_pa_range");
-    if (disp_api_get_pa_range == NULL) {
-        ALOGE("dlsym failed for disp_api_get_pa_range");
-    }
-    disp_api_get_pa_config =
-        (int(*)(int32_t, void*))dlsym(mLibHandle, "disp_api_get_pa_config");
-    if (disp_api_get_pa_config == NULL) {
-        ALOGE("dlsym failed for disp_api_get_pa_config");
-    }
-    disp_api_set_pa_config =
-        (int(*)(int32_t, void*))dlsym(mLibHandle, "disp_api_set_pa_config");
-    if (disp_api_set_pa_config == NULL) {
-        ALOGE("dlsym failed for disp_api_set_pa_config");
-    }
+    mActiveModeId = -1;
+    mDefaultPictureAdjustmentValid = false;
+    mPictureAdjustmentPristine = false;
 
     return disp_api_init(0);
 }
 
 LegacyMM::~LegacyMM() {
-    if (mLibHandle != NULL) {
-        dlclose(mLibHandle);
-    }
 }
 
 status_t LegacyMM::deinitialize() {
-    if (mLibHandle != NULL) {
+    if (mLib.isOpen()) {
         disp_api_init(1);
     }
     return OK;
@@ -137,6 +68,9 @@ bool LegacyMM::hasFeature(Feature feature) {
         default:
             return false;
     }
+    if (!mLib.provides(feature)) {
+        return false;
+    }
     if (disp_api_supported(0, id)) {
         // display modes and color balance depend on each other
         if (feature == Feature::DISPLAY_MODES ||
@@ -195,14 +129,8 @@ int LegacyMM::getNumDisplayModes() {
     return count;
 }
 
-status_t LegacyMM::getDisplayModes(List<sp<DisplayMode>>& profiles) {
-    status_t rc = OK;
-    int i = 0;
-
-    int count = getNumDisplayModes();
-
-    if (!count) return rc;
-
+status_t LegacyMM::getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                         size_t& count) {
     struct d_mode {
         int id;
         char* name;
@@ -210,24 +138,49 @@ status_t LegacyMM::getDisplayModes(List<sp<DisplayMode>>& profiles) {
         int32_t type;
     };
 
-    d_mode* tmp = new d_mode[count];
-    memset(tmp, 0, sizeof(d_mode) * count);
-    for (i = 0; i < count; i++) {
+    count = 0;
+    int num = std::min(getNumDisplayModes(), (int)std::min(capacity, (size_t)MAX_DISPLAY_MODES));
+    if (num <= 0) {
+        return OK;
+    }
+
+    // Names are written straight into the records
+    d_mode tmp[MAX_DISPLAY_MODES];
+    memset(tmp, 0, sizeof(tmp));
+    for (int i = 0; i < num; i++) {
         tmp[i].id = -1;
-        tmp[i].name = new char[128];
-        tmp[i].len = 128;
+        tmp[i].name = records[i].name;
+        tmp[i].len = DISPLAY_MODE_NAME_MAX;
+        records[i].name[0] = '\0';
     }
 
-    rc = disp_api_get_display_modes(0, 0, tmp, count);
-    if (rc == 0) {
-        for (i = 0; i < count; i++) {
-            const sp<DisplayMode> m = new DisplayMode(tmp[i].id, tmp[i].name, tmp[i].len);
-            profiles.push_back(m);
-            delete tmp[i].name;
-        }
+    status_t rc = disp_api_get_display_modes(0, 0, tmp, num);
+    if (rc != 0) {
+        return rc;
     }
-    delete[] tmp;
+    for (int i = 0; i < num; i++) {
+        records[i].id = tmp[i].id;
+        records[i].privFlags = 0;
+        records[i].name[DISPLAY_MODE_NAME_MAX - 1] = '\0';
+    }
+    count = num;
+    return OK;
+}
 
+static sp<DisplayMode> toDisplayMode(const DisplayModeRecord& record) {
+    return new DisplayMode(record.id, record.name, strnlen(record.name, DISPLAY_MODE_NAME_MAX));
+}
+
+status_t LegacyMM::getDisplayModes(List<sp<DisplayMode>>& profiles) {
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+
+    status_t rc = getDisplayModeRecords(records, MAX_DISPLAY_MODES, count);
+    if (rc == OK) {
+        for (size_t i = 0; i < count; i++) {
+            profiles.push_back(toDisplayMode(records[i]));
+        }
+    }
     return rc;
 }
 
@@ -235,6 +188,16 @@ status_t LegacyMM::setDisplayMode(int32_t modeID, bool makeDefault) {
     if (disp_api_set_active_display_mode(0, modeID) != 0) {
         return BAD_VALUE;
     }
+    mPictureAdjustmentPristine = true;
+
+    if (modeID != mActiveModeId) {
+        mActiveModeId = modeID;
+        // Only read back the first time a mode is entered
+        mDefaultPictureAdjustmentValid =
+            SettingsStore::getInstance().getPictureAdjustmentDefault(
+                modeID, mDefaultPictureAdjustment) == OK;
+        captureDefaultPictureAdjustment();
+    }
 
     if (makeDefault && disp_api_set_default_display_mode(0, modeID) != 0) {
         return BAD_VALUE;
@@ -244,13 +207,13 @@ status_t LegacyMM::setDisplayMode(int32_t modeID, bool makeDefault) {
 }
 
 sp<DisplayMode> LegacyMM::getDisplayModeById(int id) {
-    List<sp<DisplayMode>> profiles;
-    status_t rc = getDisplayModes(profiles);
-    if (rc == OK) {
-        for (List<sp<DisplayMode>>::iterator it = profiles.begin(); it != profiles.end(); ++it) {
-            const sp<DisplayMode> mode = *it;
-            if (id == mode->id) {
-                return mode;
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+
+    if (getDisplayModeRecords(records, MAX_DISPLAY_MODES, count) == OK) {
+        for (size_t i = 0; i < count; i++) {
+            if (records[i].id == id) {
+                return toDisplayMode(records[i]);
             }
         }
     }
@@ -316,11 +279,53 @@ status_t LegacyMM::getPictureAdjustment(HSIC& hsic) {
     return rc;
 }
 
-status_t LegacyMM::getDefaultPictureAdjustment(HSIC& /* hsic */) {
-    return OK;
+status_t LegacyMM::captureDefaultPictureAdjustment() {
+    if (mActiveModeId < 0) {
+        int id = -1;
+        uint32_t mask = 0;
+        if (disp_api_get_active_display_mode(0, &id, &mask) == 0 && id >= 0) {
+            mActiveModeId = id;
+            mDefaultPictureAdjustmentValid =
+                SettingsStore::getInstance().getPictureAdjustmentDefault(
+                    id, mDefaultPictureAdjustment) == OK;
+        }
+    }
+    if (mDefaultPictureAdjustmentValid) {
+        return OK;
+    }
+
+    /*
+     * The hardware only holds the defaults of the mode between applying
+     * it and the first write. Anything else may be a user setting left
+     * behind by an earlier process, which must not become the default.
+     */
+    if (!mPictureAdjustmentPristine) {
+        return NAME_NOT_FOUND;
+    }
+    HSIC tmp;
+    status_t rc = getPictureAdjustment(tmp);
+    if (rc == OK) {
+        mDefaultPictureAdjustment.setTo(tmp);
+        mDefaultPictureAdjustmentValid = true;
+        if (mActiveModeId >= 0) {
+            SettingsStore::getInstance().setPictureAdjustmentDefault(mActiveModeId, tmp);
+        }
+    }
+    return rc;
+}
+
+status_t LegacyMM::getDefaultPictureAdjustment(HSIC& hsic) {
+    status_t rc = captureDefaultPictureAdjustment();
+    if (rc == OK) {
+        hsic.setTo(mDefaultPictureAdjustment);
+    }
+    return rc;
 }
 
 status_t LegacyMM::setPictureAdjustment(HSIC hsic) {
+    captureDefaultPictureAdjustment();
+    mPictureAdjustmentPristine = false;
+
     struct mm_pa_config config;
     memset(&config, 0, sizeof(struct mm_pa_config));
 
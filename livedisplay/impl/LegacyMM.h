@@ -19,6 +19,8 @@
 
 #include <LiveDisplayBackend.h>
 
+#include "VendorLibrary.h"
+
 #define MM_DISP_LIB "libmm-disp-apis.so"
 
 namespace android {
@@ -71,6 +73,8 @@ class LegacyMM : public LiveDisplayBackend {
     virtual int32_t getColorBalance();
 
     virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles);
+    virtual status_t getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                           size_t& count);
     virtual status_t setDisplayMode(int32_t modeID, bool makeDefault);
     virtual sp<DisplayMode> getCurrentDisplayMode();
     virtual sp<DisplayMode> getDefaultDisplayMode();
@@ -85,23 +89,44 @@ class LegacyMM : public LiveDisplayBackend {
   private:
     sp<DisplayMode> getDisplayModeById(int32_t id);
     int getNumDisplayModes();
-
-    void* mLibHandle;
-
-    int (*disp_api_init)(int32_t);
-    int (*disp_api_get_color_balance_range)(int32_t, void*);
-    int (*disp_api_set_color_balance)(int32_t, int);
-    int (*disp_api_get_color_balance)(int32_t, int*);
-    int (*disp_api_get_num_display_modes)(int32_t, int32_t, int*);
-    int (*disp_api_get_display_modes)(int32_t, int32_t, void*, int);
-    int (*disp_api_get_active_display_mode)(int32_t, int*, uint32_t*);
-    int (*disp_api_set_active_display_mode)(int32_t, int);
-    int (*disp_api_set_default_display_mode)(int32_t, int);
-    int (*disp_api_get_default_display_mode)(int32_t, int*);
-    int (*disp_api_get_pa_range)(int32_t, void*);
-    int (*disp_api_get_pa_config)(int32_t, void*);
-    int (*disp_api_set_pa_config)(int32_t, void*);
-    int (*disp_api_supported)(int32_t, int32_t);
+    status_t captureDefaultPictureAdjustment();
+
+    int32_t mActiveModeId;
+    HSIC mDefaultPictureAdjustment;
+    bool mDefaultPictureAdjustmentValid;
+    // Whether the hardware still holds the defaults of a mode we applied
+    bool mPictureAdjustmentPristine;
+
+    VendorLibrary mLib{MM_DISP_LIB};
+
+    VendorFunction<int, int32_t> disp_api_init{mLib, "disp_api_init"};
+    VendorFunction<int, int32_t, int32_t> disp_api_supported{mLib, "disp_api_supported"};
+    VendorFunction<int, int32_t, void*> disp_api_get_color_balance_range{
+        mLib, "disp_api_get_color_balance_range", Feature::COLOR_TEMPERATURE};
+    VendorFunction<int, int32_t, int> disp_api_set_color_balance{
+        mLib, "disp_api_set_color_balance", Feature::COLOR_TEMPERATURE};
+    VendorFunction<int, int32_t, int*> disp_api_get_color_balance{
+        mLib, "disp_api_get_color_balance", Feature::COLOR_TEMPERATURE};
+    // Color balance needs the calibration data which comes with the modes
+    VendorFunction<int, int32_t, int32_t, int*> disp_api_get_num_display_modes{
+        mLib, "disp_api_get_num_display_modes",
+        Feature::DISPLAY_MODES | Feature::COLOR_TEMPERATURE};
+    VendorFunction<int, int32_t, int32_t, void*, int> disp_api_get_display_modes{
+        mLib, "disp_api_get_display_modes", Feature::DISPLAY_MODES};
+    VendorFunction<int, int32_t, int*, uint32_t*> disp_api_get_active_display_mode{
+        mLib, "disp_api_get_active_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int, int32_t, int> disp_api_set_active_display_mode{
+        mLib, "disp_api_set_active_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int, int32_t, int> disp_api_set_default_display_mode{
+        mLib, "disp_api_set_default_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int, int32_t, int*> disp_api_get_default_display_mode{
+        mLib, "disp_api_get_default_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int, int32_t, void*> disp_api_get_pa_range{
+        mLib, "disp_api_get_pa_range", Feature::PICTURE_ADJUSTMENT};
+    VendorFunction<int, int32_t, void*> disp_api_get_pa_config{
+        mLib, "disp_api_get_pa_config", Feature::PICTURE_ADJUSTMENT};
+    VendorFunction<int, int32_t, void*> disp_api_set_pa_config{
+        mLib, "disp_api_set_pa_config", Feature::PICTURE_ADJUSTMENT};
 };
 };
 
@@ -0,0 +1,65 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_PARALLEL_H
+#define CYNGN_PARALLEL_H
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+// Number of bands parallelFor will use, zero means one per online core
+static inline uint32_t parallelBands(uint32_t count, uint32_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        return 1;
+    }
+
+    uint32_t band = (count + threads - 1) / threads;
+    return (count + band - 1) / band;
+}
+
+/*
+ * Splits [0, count) into contiguous bands and runs fn(band, first, last)
+ * for each on its own thread. The calling thread takes the first band.
+ */
+template <typename F>
+uint32_t parallelFor(uint32_t count, uint32_t threads, F fn) {
+    threads = parallelBands(count, threads);
+
+    uint32_t band = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+
+    for (uint32_t i = 1; i < threads && i * band < count; i++) {
+        workers.push_back(std::thread(fn, i, i * band, std::min((i + 1) * band, count)));
+    }
+    fn(0, 0, std::min(band, count));
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    return workers.size() + 1;
+}
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Platform"
+
+#include <string.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "ChainedBackend.h"
+#include "LegacyMM.h"
+#include "PlatformBackend.h"
+#include "SDM.h"
+#include "SysfsBackend.h"
+
+namespace android {
+
+LiveDisplayBackend* createPlatformBackend() {
+    char board[PROPERTY_VALUE_MAX];
+    property_get("ro.board.platform", board, NULL);
+
+    LiveDisplayBackend* platform = NULL;
+    if (!strcmp(board, "msm8916") || !strcmp(board, "msm8939") || !strcmp(board, "msm8992") ||
+        !strcmp(board, "msm8974") || !strcmp(board, "msm8994")) {
+        platform = new LegacyMM();
+    } else if (!strcmp(board, "msm8996") || !strcmp(board, "msm8937") ||
+               !strcmp(board, "msm8953") || !strcmp(board, "msm8976")) {
+        platform = new SDM();
+    }
+
+    // Panel knobs in sysfs fill in for whatever the platform lacks
+    if (platform != NULL) {
+        return new ChainedBackend(platform, new SysfsBackend());
+    } else if (SysfsBackend::isPresent()) {
+        return new SysfsBackend();
+    }
+    ALOGW("No LiveDisplay backend for %s", board);
+    return NULL;
+}
+};
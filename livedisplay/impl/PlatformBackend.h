@@ -0,0 +1,34 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_PLATFORMBACKEND_H
+#define CYNGN_PLATFORMBACKEND_H
+
+#include "LiveDisplayBackend.h"
+
+namespace android {
+
+/*
+ * The vendor backend for this board, with the panel knobs in sysfs
+ * filling in for whatever it lacks. NULL if the device has neither.
+ * Only livedisplayd and the benchmarks open one, everyone else goes
+ * through RemoteBackend.
+ */
+LiveDisplayBackend* createPlatformBackend();
+};
+
+#endif
@@ -0,0 +1,48 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Remote"
+
+#include <utils/Log.h>
+
+#include "RemoteBackend.h"
+
+namespace android {
+
+status_t RemoteBackend::initialize() {
+    LiveDisplayBatch batch;
+    batch.add(OP_INITIALIZE);
+
+    status_t rc = mClient.execute(batch);
+    if (rc == OK) {
+        rc = batch.status(0);
+    }
+    if (rc != OK) {
+        ALOGE("livedisplayd has no backend: %d", rc);
+        mFeatures = 0;
+        return rc;
+    }
+    mFeatures = batch.response(0).value;
+    return OK;
+}
+
+status_t RemoteBackend::deinitialize() {
+    mFeatures = 0;
+    mClient.disconnect();
+    return OK;
+}
+};
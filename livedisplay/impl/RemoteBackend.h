@@ -0,0 +1,110 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_REMOTEBACKEND_H
+#define CYNGN_REMOTEBACKEND_H
+
+#include <LiveDisplayBackend.h>
+#include <LiveDisplayClient.h>
+
+namespace android {
+
+/*
+ * Backend living in livedisplayd, which holds the only connection to
+ * the vendor library. initialize() connects and fetches the features
+ * the daemon probed, so probing here is free. deinitialize() only
+ * hangs up, the daemon keeps its backend for everyone else.
+ */
+class RemoteBackend : public LiveDisplayBackend {
+  public:
+    RemoteBackend() : mFeatures(0) {
+    }
+
+    // Uses an already connected socket, see LiveDisplayClient
+    explicit RemoteBackend(int fd) : mClient(fd), mFeatures(0) {
+    }
+
+    virtual status_t initialize();
+    virtual status_t deinitialize();
+
+    virtual bool hasFeature(Feature feature) {
+        return mFeatures & feature;
+    }
+    virtual bool supportsConcurrentProbe() {
+        return true;
+    }
+    virtual uint32_t getSupportedFeatures() {
+        return mFeatures;
+    }
+
+    virtual status_t setAdaptiveBacklightEnabled(bool enabled) {
+        return mClient.setAdaptiveBacklightEnabled(enabled);
+    }
+    virtual bool isAdaptiveBacklightEnabled() {
+        return mClient.isAdaptiveBacklightEnabled();
+    }
+
+    virtual status_t setOutdoorModeEnabled(bool enabled) {
+        return mClient.setOutdoorModeEnabled(enabled);
+    }
+    virtual bool isOutdoorModeEnabled() {
+        return mClient.isOutdoorModeEnabled();
+    }
+
+    virtual status_t getColorBalanceRange(Range& range) {
+        return mClient.getColorBalanceRange(range);
+    }
+    virtual status_t setColorBalance(int32_t balance) {
+        return mClient.setColorBalance(balance);
+    }
+    virtual int32_t getColorBalance() {
+        return mClient.getColorBalance();
+    }
+
+    virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles) {
+        return mClient.getDisplayModes(profiles);
+    }
+    virtual status_t setDisplayMode(int32_t modeID, bool makeDefault) {
+        return mClient.setDisplayMode(modeID, makeDefault);
+    }
+    virtual sp<DisplayMode> getCurrentDisplayMode() {
+        return mClient.getCurrentDisplayMode();
+    }
+    virtual sp<DisplayMode> getDefaultDisplayMode() {
+        return mClient.getDefaultDisplayMode();
+    }
+
+    virtual status_t getPictureAdjustmentRanges(HSICRanges& ranges) {
+        return mClient.getPictureAdjustmentRanges(ranges);
+    }
+    virtual status_t getPictureAdjustment(HSIC& hsic) {
+        return mClient.getPictureAdjustment(hsic);
+    }
+    virtual status_t getDefaultPictureAdjustment(HSIC& hsic) {
+        return mClient.getDefaultPictureAdjustment(hsic);
+    }
+    virtual status_t setPictureAdjustment(HSIC hsic) {
+        return mClient.setPictureAdjustment(hsic);
+    }
+
+  private:
+    LiveDisplayClient mClient;
+    uint32_t mFeatures;
+};
+};
+
+#endif
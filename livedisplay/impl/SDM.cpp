@@ -14,13 +14,14 @@
 ** limitations under the License.
 */
 
-#include <dlfcn.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
 #include <cutils/properties.h>
+#include <utils/Timers.h>
 
 //#define LOG_NDEBUG 0
 
@@ -28,152 +29,85 @@
 #include <utils/Log.h>
 
 #include "SDM.h"
+#include "SettingsStore.h"
 #include "Utils.h"
 
 namespace android {
 
-status_t SDM::loadVendorLibrary() {
-    if (mLibHandle != NULL) {
-        return OK;
+status_t SDM::initialize() {
+    status_t rc = mLib.open();
+    if (rc != OK) {
+        return rc;
     }
 
-    mLibHandle = dlopen(SDM_DISP_LIB, RTLD_NOW);
-    if (mLibHandle == NULL) {
-        ALOGE("DLOPEN failed for %s (%s)", SDM_DISP_LIB, dlerror());
-        return NO_INIT;
-    }
-
-    disp_api_init = (int32_t(*)(int64_t*, uint32_t))dlsym(mLibHandle, "disp_api_init");
-    if (disp_api_init == NULL) {
-        ALOGE("dlsym failed for disp_api_init");
-        goto fail;
-    }
-    disp_api_deinit = (int32_t(*)(int64_t, uint32_t))dlsym(mLibHandle, "disp_api_deinit");
-    if (disp_api_deinit == NULL) {
-        ALOGE("dlsym failed for disp_api_deinit");
-        goto fail;
-    }
-    disp_api_get_global_color_balance_range = (int32_t(*)(int64_t, uint32_t, void*))dlsym(
-        mLibHandle, "disp_api_get_global_color_balance_range");
-    if (disp_api_get_global_color_balance_range == NULL) {
-        ALOGE("dlsym failed for disp_api_get_global_color_balance_range");
-        goto fail;
-    }
-    disp_api_set_global_color_balance = (int32_t(*)(int64_t, uint32_t, int32_t, uint32_t))dlsym(
-        mLibHandle, "disp_api_set_global_color_balance");
-    if (disp_api_set_global_color_balance == NULL) {
-        ALOGE("dlsym failed for disp_api_set_global_color_balance");
-        goto fail;
-    }
-    disp_api_get_global_color_balance = (int32_t(*)(int64_t, uint32_t, int32_t*, uint32_t*))dlsym(
-        mLibHandle, "disp_api_get_global_color_balance");
-    if (disp_api_get_global_color_balance == NULL) {
-        ALOGE("dlsym failed for disp_api_get_global_color_balance");
-        goto fail;
-    }
-    disp_api_get_num_display_modes =
-        (int32_t(*)(int64_t, uint32_t, int32_t, int32_t*, uint32_t*))dlsym(
-            mLibHandle, "disp_api_get_num_display_modes");
-    if (disp_api_get_num_display_modes == NULL) {
-        ALOGE("dlsym failed for disp_api_get_num_display_modes");
-        goto fail;
-    }
-    disp_api_get_display_modes =
-        (int32_t(*)(int64_t, uint32_t, int32_t, void*, int32_t, uint32_t*))dlsym(
-            mLibHandle, "disp_api_get_display_modes");
-    if (disp_api_get_display_modes == NULL) {
-        ALOGE("dlsym failed for disp_api_get_display_modes");
-        goto fail;
-    }
-    disp_api_get_active_display_mode =
-        (int32_t(*)(int64_t, uint32_t, int32_t*, uint32_t*, uint32_t*))dlsym(
-            mLibHandle, "disp_api_get_active_display_mode");
-    if (disp_api_get_active_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_get_active_display_mode");
-        goto fail;
-    }
-    disp_api_set_active_display_mode = (int32_t(*)(int64_t, uint32_t, int32_t, uint32_t))dlsym(
-        mLibHandle, "disp_api_set_active_display_mode");
-    if (disp_api_set_active_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_set_active_display_mode");
-        goto fail;
-    }
-    disp_api_set_default_display_mode = (int32_t(*)(int64_t, uint32_t, int32_t, uint32_t))dlsym(
-        mLibHandle, "disp_api_set_default_display_mode");
-    if (disp_api_set_default_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_set_default_display_mode");
-        goto fail;
-    }
-    disp_api_get_default_display_mode = (int32_t(*)(int64_t, uint32_t, int32_t*, uint32_t*))dlsym(
-        mLibHandle, "disp_api_get_default_display_mode");
-    if (disp_api_get_default_display_mode == NULL) {
-        ALOGE("dlsym failed for disp_api_get_default_display_mode");
-        goto fail;
-    }
-    disp_api_get_global_pa_range =
-        (int32_t(*)(int64_t, uint32_t, void*))dlsym(mLibHandle, "disp_api_get_global_pa_range");
-    if (disp_api_get_global_pa_range == NULL) {
-        ALOGE("dlsym failed for disp_api_get_global_pa_range");
-        goto fail;
-    }
-    disp_api_get_global_pa_config = (int32_t(*)(int64_t, uint32_t, uint32_t*, void*))dlsym(
-        mLibHandle, "disp_api_get_global_pa_config");
-    if (disp_api_get_global_pa_config == NULL) {
-        ALOGE("dlsym failed for disp_api_get_global_pa_config");
-        goto fail;
-    }
-    disp_api_set_global_pa_config = (int32_t(*)(int64_t, uint32_t, uint32_t, void*))dlsym(
-        mLibHandle, "disp_api_set_global_pa_config");
-    if (disp_api_set_global_pa_config == NULL) {
-        ALOGE("dlsym failed for disp_api_set_global_pa_config");
-        goto fail;
-    }
-    disp_api_get_feature_version = (int32_t(*)(int64_t, uint32_t, void*, uint32_t*))dlsym(
-        mLibHandle, "disp_api_get_feature_version");
-    if (disp_api_get_feature_version == NULL) {
-        ALOGE("dlsym failed for disp_api_get_feature_version");
-        goto fail;
+    rc = disp_api_init(&mHandle, 0);
+    if (rc != OK) {
+        return rc;
     }
 
-    return OK;
+    mActiveModeId = -1;
+    mActiveModeValidated = true;
+    mDefaultPictureAdjustmentValid = false;
+    mPictureAdjustmentPristine = false;
 
-fail:
-    ALOGE("Failed to link vendor library: %s", dlerror());
-    dlclose(mLibHandle);
-    mLibHandle = NULL;
-    return NO_INIT;
+    // The saved mode is restored by LiveDisplay, through setDisplayMode()
+    return OK;
 }
 
-status_t SDM::initialize() {
-    status_t rc = loadVendorLibrary();
-    if (rc != OK) {
-        return rc;
+status_t SDM::restoreDisplayMode(int32_t id) {
+    nsecs_t start = systemTime();
+
+    // sRGB is the only mode which isn't owned by SDM
+    sp<DisplayMode> mode = new DisplayMode(id, "", 0);
+    if (id == SRGB_NODE_ID) {
+        mode->privFlags = PRIV_MODE_FLAG_SYSFS;
+        mode->privData.setTo(SRGB_NODE);
+    } else {
+        mode->privFlags = PRIV_MODE_FLAG_SDM;
     }
 
-    rc = disp_api_init(&mHandle, 0);
+    status_t rc = setModeState(mode, true);
     if (rc != OK) {
+        ALOGE("Failed to restore mode %d, falling back: %d", id, rc);
         return rc;
     }
 
-    mActiveModeId = -1;
+    mActiveModeId = id;
+    mActiveModeValidated = false;
+    mPictureAdjustmentPristine = mode->privFlags == PRIV_MODE_FLAG_SDM;
+    loadDefaultPictureAdjustment();
+    ALOGD("Restored mode %d in %" PRId64 "us", id, ns2us(systemTime() - start));
+    return OK;
+}
 
-    if (hasFeature(Feature::DISPLAY_MODES)) {
-       sp<DisplayMode> defMode = getDefaultDisplayMode();
-       if (defMode != nullptr) {
-           setDisplayMode(defMode->id, false);
-       }
+void SDM::validateActiveMode() {
+    if (mActiveModeValidated) {
+        return;
+    }
+    mActiveModeValidated = true;
+
+    if (getDisplayModeById(mActiveModeId) != nullptr) {
+        return;
+    }
+
+    ALOGE("Restored mode %d no longer exists, reverting to default", mActiveModeId);
+    int32_t id = -1;
+    uint32_t flags = 0;
+    mActiveModeId = -1;
+    mDefaultPictureAdjustmentValid = false;
+    if (disp_api_get_default_display_mode(mHandle, 0, &id, &flags) == 0 && id >= 0 &&
+            disp_api_set_active_display_mode(mHandle, 0, id, 0) == 0) {
+        mActiveModeId = id;
+        mPictureAdjustmentPristine = true;
+        loadDefaultPictureAdjustment();
     }
-    return OK;
 }
 
 SDM::~SDM() {
-    if (mLibHandle != NULL) {
-        dlclose(mLibHandle);
-    }
 }
 
 status_t SDM::deinitialize() {
-    if (mLibHandle != NULL) {
+    if (mLib.isOpen()) {
         disp_api_deinit(mHandle, 0);
         mHandle = -1;
     }
@@ -226,52 +160,75 @@ uint32_t SDM::getNumDisplayModes() {
     if (disp_api_get_num_display_modes(mHandle, 0, 0, &count, &flags)) {
         count = 0;
     }
-    if (getLocalSRGBMode() != nullptr) {
+    if (hasLocalSRGBMode()) {
         count++;
     }
     return count;
 }
 
-status_t SDM::getDisplayModes(List<sp<DisplayMode>>& profiles) {
-    status_t rc = OK;
-    uint32_t flags = 0, i = 0;
-
-    uint32_t count = getNumDisplayModes();
-    if (!count) return rc;
-
-    sp<DisplayMode> srgb = getLocalSRGBMode();
-    uint32_t sdm_count = srgb == nullptr ? count : (count - 1);
-
-    struct sdm_mode {
-        int32_t id;
-        int32_t type;
-        int32_t len;
-        char* name;
-    };
+status_t SDM::getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                    size_t& count) {
+    uint32_t flags = 0;
+    int32_t sdmCount = 0;
+    count = 0;
+
+    if (disp_api_get_num_display_modes(mHandle, 0, 0, &sdmCount, &flags) != 0) {
+        sdmCount = 0;
+    }
+    sdmCount = std::min(sdmCount, (int32_t)std::min(capacity, (size_t)MAX_DISPLAY_MODES));
+
+    if (sdmCount > 0) {
+        // Names are written straight into the records
+        sdm_mode tmp[MAX_DISPLAY_MODES];
+        memset(tmp, 0, sizeof(tmp));
+        for (int32_t i = 0; i < sdmCount; i++) {
+            tmp[i].id = -1;
+            tmp[i].name = records[i].name;
+            tmp[i].len = DISPLAY_MODE_NAME_MAX;
+            records[i].name[0] = '\0';
+        }
 
-    sdm_mode* tmp = new sdm_mode[sdm_count];
-    memset(tmp, 0, sizeof(sdm_mode) * sdm_count);
-    for (i = 0; i < sdm_count; i++) {
-        tmp[i].id = -1;
-        tmp[i].name = new char[128];
-        tmp[i].len = 128;
-    }
-
-    rc = disp_api_get_display_modes(mHandle, 0, 0, tmp, sdm_count, &flags);
-    if (rc == 0) {
-        for (i = 0; i < sdm_count; i++) {
-            const sp<DisplayMode> m = new DisplayMode(tmp[i].id, tmp[i].name, tmp[i].len);
-            m->privFlags = PRIV_MODE_FLAG_SDM;
-            profiles.push_back(m);
-            delete tmp[i].name;
+        status_t rc = disp_api_get_display_modes(mHandle, 0, 0, tmp, sdmCount, &flags);
+        if (rc != 0) {
+            return rc;
         }
+        for (int32_t i = 0; i < sdmCount; i++) {
+            records[i].id = tmp[i].id;
+            records[i].privFlags = PRIV_MODE_FLAG_SDM;
+            records[i].name[DISPLAY_MODE_NAME_MAX - 1] = '\0';
+        }
+        count = sdmCount;
+    }
+
+    if (count < capacity && hasLocalSRGBMode()) {
+        DisplayModeRecord& r = records[count++];
+        r.id = SRGB_NODE_ID;
+        r.privFlags = PRIV_MODE_FLAG_SYSFS;
+        strcpy(r.name, "srgb");
     }
-    delete[] tmp;
+    return OK;
+}
 
-    if (srgb != nullptr) {
-        profiles.push_back(srgb);
+static sp<DisplayMode> toDisplayMode(const DisplayModeRecord& record) {
+    sp<DisplayMode> m =
+        new DisplayMode(record.id, record.name, strnlen(record.name, DISPLAY_MODE_NAME_MAX));
+    m->privFlags = record.privFlags;
+    if (record.privFlags == PRIV_MODE_FLAG_SYSFS) {
+        m->privData.setTo(SRGB_NODE);
     }
+    return m;
+}
 
+status_t SDM::getDisplayModes(List<sp<DisplayMode>>& profiles) {
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+
+    status_t rc = getDisplayModeRecords(records, MAX_DISPLAY_MODES, count);
+    if (rc == OK) {
+        for (size_t i = 0; i < count; i++) {
+            profiles.push_back(toDisplayMode(records[i]));
+        }
+    }
     return rc;
 }
 
@@ -282,6 +239,12 @@ status_t SDM::setDisplayMode(int32_t modeID, bool makeDefault) {
         return OK;
     }
 
+    // Nothing applied since initialize(), so this is the restore: apply
+    // the saved id without listing the modes and validate it later
+    if (mActiveModeId < 0 && !makeDefault && restoreDisplayMode(modeID) == OK) {
+        return OK;
+    }
+
     sp<DisplayMode> mode = getDisplayModeById(modeID);
     if (mode == nullptr) {
         return BAD_VALUE;
@@ -291,9 +254,8 @@ status_t SDM::setDisplayMode(int32_t modeID, bool makeDefault) {
 
     if (mActiveModeId >= 0) {
         sp<DisplayMode> oldMode = getDisplayModeById(mActiveModeId);
-        ALOGV("setDisplayMode: oldMode=%d flags=%d", oldMode->id, oldMode->privFlags);
-        if (oldMode->privFlags == PRIV_MODE_FLAG_SYSFS ||
-                mode->privFlags == PRIV_MODE_FLAG_SYSFS) {
+        if (oldMode != nullptr && needsTeardown(oldMode, mode)) {
+            ALOGV("setDisplayMode: oldMode=%d flags=%d", oldMode->id, oldMode->privFlags);
             ALOGV("disabling old mode");
             rc = setModeState(oldMode, false);
             if (rc != OK) {
@@ -306,21 +268,20 @@ status_t SDM::setDisplayMode(int32_t modeID, bool makeDefault) {
     rc = setModeState(mode, true);
     if (rc == OK) {
         mActiveModeId = mode->id;
+        mActiveModeValidated = true;
+        // The sysfs sRGB mode leaves the SDM picture adjustment alone
+        mPictureAdjustmentPristine = mode->privFlags == PRIV_MODE_FLAG_SDM;
         if (makeDefault) {
-            rc = Utils::writeLocalModeId(mode->id);
+            rc = SettingsStore::getInstance().setModeId(mode->id);
             if (rc != OK) {
                 ALOGE("failed to save mode! %d", rc);
                 return rc;
             }
         }
-        HSIC tmp;
-        rc = getPictureAdjustment(tmp);
-        if (rc != OK) {
+        // Only read back the first time a mode is entered
+        loadDefaultPictureAdjustment();
+        if (captureDefaultPictureAdjustment() != OK) {
             ALOGE("failed to retrieve picture adjustment after mode setting!");
-        } else {
-            ALOGV("new default PA: %d %f %f %f %f", tmp.hue, tmp.saturation,
-                    tmp.intensity, tmp.contrast, tmp.saturationThreshold);
-            mDefaultPictureAdjustment.setTo(tmp);
         }
     } else {
         ALOGE("Failed to setModeState! err=%d", rc);
@@ -331,14 +292,31 @@ status_t SDM::setDisplayMode(int32_t modeID, bool makeDefault) {
     return OK;
 }
 
+bool SDM::needsTeardown(const sp<DisplayMode>& oldMode, const sp<DisplayMode>& newMode) {
+    // The sysfs node has to be cleared before any other mode applies
+    if (oldMode->privFlags == PRIV_MODE_FLAG_SYSFS) {
+        return true;
+    }
+    if (newMode->privFlags != PRIV_MODE_FLAG_SYSFS) {
+        return false;
+    }
+
+    // Going to sysfs from SDM resets SDM to its default mode, which is
+    // pointless if that's already the one applied
+    int32_t id = -1;
+    uint32_t flags = 0;
+    return disp_api_get_default_display_mode(mHandle, 0, &id, &flags) != 0 ||
+           id != oldMode->id;
+}
+
 sp<DisplayMode> SDM::getDisplayModeById(int32_t id) {
-    List<sp<DisplayMode>> profiles;
-    status_t rc = getDisplayModes(profiles);
-    if (rc == OK) {
-        for (List<sp<DisplayMode>>::iterator it = profiles.begin(); it != profiles.end(); ++it) {
-            const sp<DisplayMode> mode = *it;
-            if (id == mode->id) {
-                return mode;
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+
+    if (getDisplayModeRecords(records, MAX_DISPLAY_MODES, count) == OK) {
+        for (size_t i = 0; i < count; i++) {
+            if (records[i].id == id) {
+                return toDisplayMode(records[i]);
             }
         }
     }
@@ -347,12 +325,13 @@ sp<DisplayMode> SDM::getDisplayModeById(int32_t id) {
 }
 
 sp<DisplayMode> SDM::getCurrentDisplayMode() {
+    validateActiveMode();
     return getDisplayModeById(mActiveModeId);
 }
 
 sp<DisplayMode> SDM::getDefaultDisplayMode() {
     int32_t id = 0;
-    if (Utils::readLocalModeId(&id) == OK && id >= 0) {
+    if (SettingsStore::getInstance().getModeId(id) == OK && id >= 0) {
         return getDisplayModeById(id);
     }
     return nullptr;
@@ -378,17 +357,8 @@ status_t SDM::setModeState(sp<DisplayMode> mode, bool state) {
     return BAD_VALUE;
 }
 
-sp<DisplayMode> SDM::getLocalSRGBMode() {
-    char path[PATH_MAX];
-    sprintf(path, "%s", SRGB_NODE);
-
-    if (access(path, W_OK) != 0) {
-        return nullptr;
-    }
-    sp<DisplayMode> m = new DisplayMode(SRGB_NODE_ID, "srgb", 4);
-    m->privFlags = PRIV_MODE_FLAG_SYSFS;
-    m->privData.setTo(path);
-    return m;
+bool SDM::hasLocalSRGBMode() {
+    return access(SRGB_NODE, W_OK) == 0;
 }
 
 status_t SDM::getPictureAdjustmentRanges(HSICRanges& ranges) {
@@ -432,12 +402,52 @@ status_t SDM::getPictureAdjustment(HSIC& hsic) {
     return rc;
 }
 
+status_t SDM::captureDefaultPictureAdjustment() {
+    if (mDefaultPictureAdjustmentValid) {
+        return OK;
+    }
+
+    /*
+     * The hardware only holds the defaults of the mode between applying
+     * it and the first write. Anything else may be a user setting left
+     * behind by an earlier process, which must not become the default.
+     */
+    if (!mPictureAdjustmentPristine) {
+        return NAME_NOT_FOUND;
+    }
+    HSIC tmp;
+    status_t rc = getPictureAdjustment(tmp);
+    if (rc == OK) {
+        ALOGV("new default PA: %d %f %f %f %f", tmp.hue, tmp.saturation, tmp.intensity,
+              tmp.contrast, tmp.saturationThreshold);
+        mDefaultPictureAdjustment.setTo(tmp);
+        mDefaultPictureAdjustmentValid = true;
+        if (mActiveModeId >= 0) {
+            SettingsStore::getInstance().setPictureAdjustmentDefault(mActiveModeId, tmp);
+        }
+    }
+    return rc;
+}
+
+void SDM::loadDefaultPictureAdjustment() {
+    mDefaultPictureAdjustmentValid =
+        mActiveModeId >= 0 &&
+        SettingsStore::getInstance().getPictureAdjustmentDefault(
+            mActiveModeId, mDefaultPictureAdjustment) == OK;
+}
+
 status_t SDM::getDefaultPictureAdjustment(HSIC& hsic) {
-    hsic.setTo(mDefaultPictureAdjustment);
-    return OK;
+    status_t rc = captureDefaultPictureAdjustment();
+    if (rc == OK) {
+        hsic.setTo(mDefaultPictureAdjustment);
+    }
+    return rc;
 }
 
 status_t SDM::setPictureAdjustment(HSIC hsic) {
+    captureDefaultPictureAdjustment();
+    mPictureAdjustmentPristine = false;
+
     hsic_config config;
     memset(&config, 0, sizeof(struct hsic_config));
     config.data.hue = hsic.hue;
@@ -475,6 +485,9 @@ bool SDM::hasFeature(Feature feature) {
             return false;
     }
 
+    if (!mLib.provides(feature)) {
+        return false;
+    }
     if (disp_api_get_feature_version(mHandle, id, &v, &flags) == 0) {
         if (v.x > 0 || v.y > 0 || v.z > 0) {
 
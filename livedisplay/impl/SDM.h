@@ -3,6 +3,8 @@
 
 #include <LiveDisplayBackend.h>
 
+#include "VendorLibrary.h"
+
 #define SDM_DISP_LIB "libsdm-disp-apis.so"
 
 #define DPPS_BUF_SIZE 64
@@ -54,12 +56,24 @@ struct hsic_ranges {
     struct hsic_float_range saturationThreshold;
 };
 
+struct sdm_mode {
+    int32_t id;
+    int32_t type;
+    int32_t len;
+    char* name;
+};
+
 class SDM : public LiveDisplayBackend {
   public:
     virtual status_t initialize();
     virtual status_t deinitialize();
     virtual bool hasFeature(Feature feature);
 
+    // Probes are independent queries to the display service
+    virtual bool supportsConcurrentProbe() {
+        return true;
+    }
+
     virtual status_t setAdaptiveBacklightEnabled(bool enabled);
     virtual bool isAdaptiveBacklightEnabled();
 
@@ -75,6 +89,8 @@ class SDM : public LiveDisplayBackend {
     virtual int32_t getColorBalance();
 
     virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles);
+    virtual status_t getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                           size_t& count);
     virtual status_t setDisplayMode(int32_t modeID, bool makeDefault);
     virtual sp<DisplayMode> getCurrentDisplayMode();
     virtual sp<DisplayMode> getDefaultDisplayMode();
@@ -87,9 +103,14 @@ class SDM : public LiveDisplayBackend {
     virtual ~SDM();
 
   private:
-    status_t loadVendorLibrary();
+    status_t restoreDisplayMode(int32_t id);
+    void validateActiveMode();
+    status_t captureDefaultPictureAdjustment();
+    void loadDefaultPictureAdjustment();
+
+    bool needsTeardown(const sp<DisplayMode>& oldMode, const sp<DisplayMode>& newMode);
 
-    sp<DisplayMode> getLocalSRGBMode();
+    bool hasLocalSRGBMode();
     sp<DisplayMode> getDisplayModeById(int32_t id);
     status_t setModeState(sp<DisplayMode> mode, bool state);
     uint32_t getNumDisplayModes();
@@ -97,26 +118,51 @@ class SDM : public LiveDisplayBackend {
     int64_t mHandle;
     bool mCachedFOSSStatus;
     int32_t mActiveModeId;
+    bool mActiveModeValidated;
 
     HSIC mDefaultPictureAdjustment;
-
-    void* mLibHandle;
-
-    int32_t (*disp_api_init)(int64_t*, uint32_t);
-    int32_t (*disp_api_deinit)(int64_t, uint32_t);
-    int32_t (*disp_api_get_global_color_balance_range)(int64_t, uint32_t, void*);
-    int32_t (*disp_api_set_global_color_balance)(int64_t, uint32_t, int32_t, uint32_t);
-    int32_t (*disp_api_get_global_color_balance)(int64_t, uint32_t, int32_t*, uint32_t*);
-    int32_t (*disp_api_get_num_display_modes)(int64_t, uint32_t, int32_t, int32_t*, uint32_t*);
-    int32_t (*disp_api_get_display_modes)(int64_t, uint32_t, int32_t, void*, int32_t, uint32_t*);
-    int32_t (*disp_api_get_active_display_mode)(int64_t, uint32_t, int32_t*, uint32_t*, uint32_t*);
-    int32_t (*disp_api_set_active_display_mode)(int64_t, uint32_t, int32_t, uint32_t);
-    int32_t (*disp_api_set_default_display_mode)(int64_t, uint32_t, int32_t, uint32_t);
-    int32_t (*disp_api_get_default_display_mode)(int64_t, uint32_t, int32_t*, uint32_t*);
-    int32_t (*disp_api_get_global_pa_range)(int64_t, uint32_t, void*);
-    int32_t (*disp_api_get_global_pa_config)(int64_t, uint32_t, uint32_t*, void*);
-    int32_t (*disp_api_set_global_pa_config)(int64_t, uint32_t, uint32_t, void*);
-    int32_t (*disp_api_get_feature_version)(int64_t, uint32_t, void*, uint32_t*);
+    bool mDefaultPictureAdjustmentValid;
+    // Whether the hardware still holds the defaults of a mode we applied
+    bool mPictureAdjustmentPristine;
+
+    VendorLibrary mLib{SDM_DISP_LIB};
+
+    VendorFunction<int32_t, int64_t*, uint32_t> disp_api_init{mLib, "disp_api_init"};
+    VendorFunction<int32_t, int64_t, uint32_t> disp_api_deinit{mLib, "disp_api_deinit"};
+    VendorFunction<int32_t, int64_t, uint32_t, void*, uint32_t*> disp_api_get_feature_version{
+        mLib, "disp_api_get_feature_version"};
+    VendorFunction<int32_t, int64_t, uint32_t, void*> disp_api_get_global_color_balance_range{
+        mLib, "disp_api_get_global_color_balance_range", Feature::COLOR_TEMPERATURE};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t, uint32_t>
+        disp_api_set_global_color_balance{
+            mLib, "disp_api_set_global_color_balance", Feature::COLOR_TEMPERATURE};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t*, uint32_t*>
+        disp_api_get_global_color_balance{
+            mLib, "disp_api_get_global_color_balance", Feature::COLOR_TEMPERATURE};
+    // Color balance depends on calibration data which comes with the modes
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t, int32_t*, uint32_t*>
+        disp_api_get_num_display_modes{mLib, "disp_api_get_num_display_modes",
+                                       Feature::DISPLAY_MODES | Feature::COLOR_TEMPERATURE};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t, void*, int32_t, uint32_t*>
+        disp_api_get_display_modes{mLib, "disp_api_get_display_modes", Feature::DISPLAY_MODES};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t*, uint32_t*, uint32_t*>
+        disp_api_get_active_display_mode{
+            mLib, "disp_api_get_active_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t, uint32_t>
+        disp_api_set_active_display_mode{
+            mLib, "disp_api_set_active_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t, uint32_t>
+        disp_api_set_default_display_mode{
+            mLib, "disp_api_set_default_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int32_t, int64_t, uint32_t, int32_t*, uint32_t*>
+        disp_api_get_default_display_mode{
+            mLib, "disp_api_get_default_display_mode", Feature::DISPLAY_MODES};
+    VendorFunction<int32_t, int64_t, uint32_t, void*> disp_api_get_global_pa_range{
+        mLib, "disp_api_get_global_pa_range", Feature::PICTURE_ADJUSTMENT};
+    VendorFunction<int32_t, int64_t, uint32_t, uint32_t*, void*> disp_api_get_global_pa_config{
+        mLib, "disp_api_get_global_pa_config", Feature::PICTURE_ADJUSTMENT};
+    VendorFunction<int32_t, int64_t, uint32_t, uint32_t, void*> disp_api_set_global_pa_config{
+        mLib, "disp_api_set_global_pa_config", Feature::PICTURE_ADJUSTMENT};
 };
 };
 
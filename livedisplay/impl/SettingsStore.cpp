@@ -0,0 +1,444 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Settings"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "SettingsStore.h"
+#include "Utils.h"
+
+#define SETTINGS_MAGIC 0x5453434c  // "LCST"
+#define SETTINGS_VERSION 2
+// Before the picture adjustment defaults moved in
+#define SETTINGS_VERSION_1 1
+
+// Files written by earlier versions, imported once and removed
+#define LEGACY_MODE_ID "livedisplay_mode"
+#define LEGACY_STATE "livedisplay_state"
+#define LEGACY_STATE_MAGIC 0x5453444c  // "LDST"
+#define LEGACY_STATE_VERSION 1
+#define LEGACY_PA_DEFAULTS "livedisplay_pa_defaults"
+#define LEGACY_PA_DEFAULTS_MAGIC 0x4641504c  // "LPAF"
+#define LEGACY_PA_DEFAULTS_VERSION 1
+
+namespace android {
+
+ANDROID_SINGLETON_STATIC_INSTANCE(SettingsStore)
+
+struct local_settings_v1 {
+    uint32_t present;
+    int32_t modeId;
+    local_state state;
+};
+
+struct legacy_pa_defaults {
+    uint32_t count;
+    local_pa_default entries[MAX_PA_DEFAULTS];
+};
+
+static void resetSettings(local_settings& s) {
+    memset(&s, 0, sizeof(s));
+    s.modeId = -1;
+}
+
+static status_t readSettings(local_settings& s) {
+    status_t rc = Utils::readLocalFile(SETTINGS_FILE, SETTINGS_MAGIC, SETTINGS_VERSION, &s,
+                                       sizeof(s));
+    if (rc == OK) {
+        s.paDefaultCount = std::min(s.paDefaultCount, (uint32_t)MAX_PA_DEFAULTS);
+    }
+    return rc;
+}
+
+static local_pa_default* findPaDefault(local_settings& s, int32_t modeId) {
+    for (uint32_t i = 0; i < s.paDefaultCount; i++) {
+        if (s.paDefaults[i].modeId == modeId) {
+            return &s.paDefaults[i];
+        }
+    }
+    return NULL;
+}
+
+// Adds or replaces the entry for e.modeId, false if the table is full
+static bool putPaDefault(local_settings& s, const local_pa_default& e) {
+    local_pa_default* d = findPaDefault(s, e.modeId);
+    if (d == NULL) {
+        if (s.paDefaultCount >= MAX_PA_DEFAULTS) {
+            return false;
+        }
+        d = &s.paDefaults[s.paDefaultCount++];
+    }
+    *d = e;
+    s.present |= SETTING_PA_DEFAULTS;
+    return true;
+}
+
+// Held around every read-modify-write of the settings file, across processes
+static int lockSettings() {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", LOCAL_STORAGE_PATH, SETTINGS_LOCK_FILE);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (flock(fd, LOCK_EX) < 0) {
+        int rc = -errno;
+        close(fd);
+        return rc;
+    }
+    return fd;
+}
+
+static void unlockSettings(int fd) {
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+SettingsStore::SettingsStore()
+    : mLoaded(false),
+      mDirty(false),
+      mChanged(0),
+      mExiting(false),
+      mDirtySince(0),
+      mFlushAt(0) {
+    resetSettings(mSettings);
+}
+
+SettingsStore::~SettingsStore() {
+    {
+        Mutex::Autolock _l(mLock);
+        mExiting = true;
+        mCondition.signal();
+    }
+    if (mFlusher.joinable()) {
+        mFlusher.join();
+    }
+    write();
+}
+
+void SettingsStore::load() {
+    if (mLoaded) {
+        return;
+    }
+    mLoaded = true;
+
+    status_t rc = readSettings(mSettings);
+    if (rc == OK) {
+        return;
+    }
+
+    resetSettings(mSettings);
+
+    // A version mismatch may just be a file from before an upgrade
+    if (rc == NAME_NOT_FOUND || rc == BAD_TYPE) {
+        importLegacy();
+    }
+    if (rc != NAME_NOT_FOUND && mSettings.present == 0) {
+        ALOGE("Discarding saved settings: %d", rc);
+    }
+}
+
+void SettingsStore::importLegacy() {
+    char path[PATH_MAX];
+    int32_t id = -1;
+
+    snprintf(path, sizeof(path), "%s/%s", LOCAL_STORAGE_PATH, LEGACY_MODE_ID);
+    if (Utils::readInt(path, &id) == OK && id >= 0) {
+        mSettings.modeId = id;
+        mSettings.present |= SETTING_MODE_ID;
+    }
+    if (Utils::readLocalFile(LEGACY_STATE, LEGACY_STATE_MAGIC, LEGACY_STATE_VERSION,
+                             &mSettings.state, sizeof(mSettings.state)) == OK) {
+        mSettings.present |= SETTING_STATE;
+    }
+
+    local_settings_v1 v1;
+    if (Utils::readLocalFile(SETTINGS_FILE, SETTINGS_MAGIC, SETTINGS_VERSION_1, &v1,
+                             sizeof(v1)) == OK) {
+        mSettings.present |= v1.present & (SETTING_MODE_ID | SETTING_STATE);
+        if (v1.present & SETTING_MODE_ID) {
+            mSettings.modeId = v1.modeId;
+        }
+        if (v1.present & SETTING_STATE) {
+            mSettings.state = v1.state;
+        }
+    }
+
+    legacy_pa_defaults pa;
+    if (Utils::readLocalFile(LEGACY_PA_DEFAULTS, LEGACY_PA_DEFAULTS_MAGIC,
+                             LEGACY_PA_DEFAULTS_VERSION, &pa, sizeof(pa)) == OK) {
+        for (uint32_t i = 0; i < pa.count && i < MAX_PA_DEFAULTS; i++) {
+            putPaDefault(mSettings, pa.entries[i]);
+        }
+    }
+    if (mSettings.present == 0) {
+        return;
+    }
+
+    // Only drop the old files once their contents are safely stored
+    int lock = lockSettings();
+    if (lock < 0) {
+        ALOGE("Failed to lock settings: %d", lock);
+        return;
+    }
+    status_t rc = Utils::writeLocalFile(SETTINGS_FILE, SETTINGS_MAGIC, SETTINGS_VERSION,
+                                        &mSettings, sizeof(mSettings));
+    unlockSettings(lock);
+    if (rc != OK) {
+        ALOGE("Failed to import settings: %d", rc);
+        return;
+    }
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s", LOCAL_STORAGE_PATH, LEGACY_STATE);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s", LOCAL_STORAGE_PATH, LEGACY_PA_DEFAULTS);
+    unlink(path);
+}
+
+status_t SettingsStore::getModeId(int32_t& id) {
+    Mutex::Autolock _l(mLock);
+    load();
+
+    if (!(mSettings.present & SETTING_MODE_ID)) {
+        return NAME_NOT_FOUND;
+    }
+    id = mSettings.modeId;
+    return OK;
+}
+
+status_t SettingsStore::setModeId(int32_t id) {
+    Mutex::Autolock _l(mLock);
+    load();
+
+    if ((mSettings.present & SETTING_MODE_ID) && mSettings.modeId == id) {
+        return OK;
+    }
+    mSettings.modeId = id;
+    mSettings.present |= SETTING_MODE_ID;
+    mChanged |= SETTING_MODE_ID;
+    changed();
+    return OK;
+}
+
+status_t SettingsStore::getState(DisplayState& state) {
+    Mutex::Autolock _l(mLock);
+    load();
+
+    if (!(mSettings.present & SETTING_STATE)) {
+        return NAME_NOT_FOUND;
+    }
+
+    const local_state& s = mSettings.state;
+    state.features = s.features;
+    state.modeId = s.modeId;
+    state.colorBalance = s.colorBalance;
+    state.pictureAdjustment = HSIC(s.hue, s.saturation, s.intensity, s.contrast,
+                                   s.saturationThreshold);
+    state.outdoorMode = s.outdoorMode != 0;
+    state.adaptiveBacklight = s.adaptiveBacklight != 0;
+    return OK;
+}
+
+status_t SettingsStore::setState(const DisplayState& state) {
+    local_state s;
+    memset(&s, 0, sizeof(s));
+
+    s.features = state.features;
+    s.modeId = state.modeId;
+    s.colorBalance = state.colorBalance;
+    s.hue = state.pictureAdjustment.hue;
+    s.saturation = state.pictureAdjustment.saturation;
+    s.intensity = state.pictureAdjustment.intensity;
+    s.contrast = state.pictureAdjustment.contrast;
+    s.saturationThreshold = state.pictureAdjustment.saturationThreshold;
+    s.outdoorMode = state.outdoorMode;
+    s.adaptiveBacklight = state.adaptiveBacklight;
+
+    Mutex::Autolock _l(mLock);
+    load();
+
+    if ((mSettings.present & SETTING_STATE) && memcmp(&mSettings.state, &s, sizeof(s)) == 0) {
+        return OK;
+    }
+    mSettings.state = s;
+    mSettings.present |= SETTING_STATE;
+    mChanged |= SETTING_STATE;
+    changed();
+    return OK;
+}
+
+status_t SettingsStore::getPictureAdjustmentDefault(int32_t modeId, HSIC& hsic) {
+    Mutex::Autolock _l(mLock);
+    load();
+
+    const local_pa_default* d = findPaDefault(mSettings, modeId);
+    if (d == NULL) {
+        return NAME_NOT_FOUND;
+    }
+    hsic.setTo(HSIC(d->hue, d->saturation, d->intensity, d->contrast, d->saturationThreshold));
+    return OK;
+}
+
+status_t SettingsStore::setPictureAdjustmentDefault(int32_t modeId, const HSIC& hsic) {
+    local_pa_default e;
+    memset(&e, 0, sizeof(e));
+
+    e.modeId = modeId;
+    e.hue = hsic.hue;
+    e.saturation = hsic.saturation;
+    e.intensity = hsic.intensity;
+    e.contrast = hsic.contrast;
+    e.saturationThreshold = hsic.saturationThreshold;
+
+    Mutex::Autolock _l(mLock);
+    load();
+
+    const local_pa_default* d = findPaDefault(mSettings, modeId);
+    if (d != NULL && memcmp(d, &e, sizeof(e)) == 0) {
+        return OK;
+    }
+    if (!putPaDefault(mSettings, e)) {
+        ALOGE("Too many display modes, not saving defaults for %d", modeId);
+        return NO_MEMORY;
+    }
+    mChanged |= SETTING_PA_DEFAULTS;
+    changed();
+    return OK;
+}
+
+status_t SettingsStore::flush() {
+    return write();
+}
+
+// Called with mLock held
+void SettingsStore::changed() {
+    nsecs_t now = systemTime();
+    if (!mDirty) {
+        mDirty = true;
+        mDirtySince = now;
+    }
+    mFlushAt = std::min(now + ms2ns(SETTINGS_FLUSH_DELAY_MS),
+                        mDirtySince + ms2ns(SETTINGS_FLUSH_MAX_DELAY_MS));
+
+    if (!mFlusher.joinable()) {
+        mFlusher = std::thread(&SettingsStore::flushLoop, this);
+    }
+    mCondition.signal();
+}
+
+void SettingsStore::flushLoop() {
+    mLock.lock();
+    while (!mExiting) {
+        if (!mDirty) {
+            mCondition.wait(mLock);
+            continue;
+        }
+        nsecs_t now = systemTime();
+        if (now < mFlushAt) {
+            mCondition.waitRelative(mLock, mFlushAt - now);
+            continue;
+        }
+        mLock.unlock();
+        write();
+        mLock.lock();
+    }
+    mLock.unlock();
+}
+
+// Copies the settings named by the SETTING_* bits in which from src
+static void mergeSettings(local_settings& dst, const local_settings& src, uint32_t which) {
+    which &= src.present;
+    if (which & SETTING_MODE_ID) {
+        dst.modeId = src.modeId;
+    }
+    if (which & SETTING_STATE) {
+        dst.state = src.state;
+    }
+    // Entries are per mode, so keep the modes only the other side knows
+    if (which & SETTING_PA_DEFAULTS) {
+        for (uint32_t i = 0; i < src.paDefaultCount; i++) {
+            putPaDefault(dst, src.paDefaults[i]);
+        }
+    }
+    dst.present |= which;
+}
+
+status_t SettingsStore::write() {
+    Mutex::Autolock _w(mWriteLock);
+    local_settings s;
+    uint32_t changed;
+    {
+        Mutex::Autolock _l(mLock);
+        if (!mDirty) {
+            return OK;
+        }
+        s = mSettings;
+        changed = mChanged;
+        mChanged = 0;
+        mDirty = false;
+    }
+
+    status_t rc = OK;
+    local_settings stored;
+    int lock = lockSettings();
+    if (lock < 0) {
+        rc = lock;
+    } else {
+        // Start from what is on disk, other processes may have written since
+        if (readSettings(stored) != OK) {
+            resetSettings(stored);
+        }
+        local_settings merged = stored;
+        mergeSettings(merged, s, changed);
+        rc = Utils::writeLocalFile(SETTINGS_FILE, SETTINGS_MAGIC, SETTINGS_VERSION, &merged,
+                                   sizeof(merged));
+        unlockSettings(lock);
+    }
+
+    Mutex::Autolock _l(mLock);
+    if (rc != OK) {
+        ALOGE("Failed to write settings: %d", rc);
+        nsecs_t now = systemTime();
+        if (!mDirty) {
+            mDirty = true;
+            mDirtySince = now;
+        }
+        mChanged |= changed;
+        if (!mExiting) {
+            mFlushAt = now + ms2ns(SETTINGS_RETRY_DELAY_MS);
+            mCondition.signal();
+        }
+        return rc;
+    }
+
+    // Pick up what the others stored, unless it was changed here again
+    mergeSettings(mSettings, stored, ~(changed | mChanged));
+    return OK;
+}
+};
@@ -0,0 +1,143 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_SETTINGSSTORE_H
+#define CYNGN_SETTINGSSTORE_H
+
+#include <thread>
+
+#include <utils/Condition.h>
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+#include <utils/Singleton.h>
+#include <utils/Timers.h>
+
+#include "Types.h"
+
+#define SETTINGS_FILE "livedisplay_settings"
+#define SETTINGS_LOCK_FILE "livedisplay_settings.lock"
+
+// Changes are written out once no more arrive for this long
+#define SETTINGS_FLUSH_DELAY_MS 500
+// ... but never later than this after the first unwritten change
+#define SETTINGS_FLUSH_MAX_DELAY_MS 2000
+// A failed write is tried again after this long
+#define SETTINGS_RETRY_DELAY_MS 5000
+
+#define MAX_PA_DEFAULTS 32
+
+namespace android {
+
+struct local_state {
+    uint32_t features;
+    int32_t modeId;
+    int32_t colorBalance;
+    int32_t hue;
+    float saturation;
+    float intensity;
+    float contrast;
+    float saturationThreshold;
+    uint8_t outdoorMode;
+    uint8_t adaptiveBacklight;
+    uint8_t reserved[2];
+};
+
+struct local_pa_default {
+    int32_t modeId;
+    int32_t hue;
+    float saturation;
+    float intensity;
+    float contrast;
+    float saturationThreshold;
+};
+
+enum {
+    SETTING_MODE_ID = 0x1,
+    SETTING_STATE = 0x2,
+    SETTING_PA_DEFAULTS = 0x4,
+};
+
+struct local_settings {
+    uint32_t present;  // SETTING_* bits of the fields below which were stored
+    int32_t modeId;    // default display mode
+    local_state state;
+    uint32_t paDefaultCount;
+    local_pa_default paDefaults[MAX_PA_DEFAULTS];
+};
+
+/*
+ * Every setting LiveDisplay persists, kept in one fixed layout file.
+ * The file is read once, and updates are written back in the
+ * background after a short delay so a burst of changes is written out
+ * once. Writes go to a temporary file which is renamed over the old
+ * one, so a crash leaves either version intact.
+ *
+ * Several processes may share the file. A write holds a lock file,
+ * reloads the file and only replaces the settings this process changed,
+ * so it never rolls back what another process stored in the meantime.
+ */
+class SettingsStore : public Singleton<SettingsStore> {
+    friend class Singleton;
+
+  public:
+    status_t getModeId(int32_t& id);
+    status_t setModeId(int32_t id);
+
+    status_t getState(DisplayState& state);
+    status_t setState(const DisplayState& state);
+
+    /*
+     * Default picture adjustment of each display mode. Modes reset the
+     * picture adjustment when they are applied, so the backends read the
+     * values back from the hardware once, right after a mode is first
+     * applied and before any write, and keep them here so later switches
+     * and reboots don't need to.
+     */
+    status_t getPictureAdjustmentDefault(int32_t modeId, HSIC& hsic);
+    status_t setPictureAdjustmentDefault(int32_t modeId, const HSIC& hsic);
+
+    // Writes any pending changes before returning
+    status_t flush();
+
+    SettingsStore();
+    ~SettingsStore();
+
+  private:
+    void load();
+    void importLegacy();
+    void changed();
+    void flushLoop();
+    status_t write();
+
+    local_settings mSettings;
+    bool mLoaded;
+    bool mDirty;
+    uint32_t mChanged;  // SETTING_* bits not written out yet
+    bool mExiting;
+    nsecs_t mDirtySince;
+    nsecs_t mFlushAt;
+
+    std::thread mFlusher;
+    Condition mCondition;
+    Mutex mLock;
+
+    // Serializes writers of the file, held without mLock
+    Mutex mWriteLock;
+};
+};
+
+#endif
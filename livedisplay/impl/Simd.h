@@ -0,0 +1,365 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_SIMD_H
+#define CYNGN_SIMD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_SSE2 1
+#endif
+
+/*
+ * Minimal 4-wide float vector layer for the color math kernels.
+ * NEON and SSE2 map directly onto intrinsics, anything else falls
+ * back to plain loops that the compiler may still vectorize.
+ */
+namespace android {
+namespace simd {
+
+#if defined(SIMD_NEON)
+
+typedef float32x4_t f32x4;
+typedef int32x4_t i32x4;
+typedef uint32x4_t m32x4;
+
+static inline f32x4 load(const float* p) {
+    return vld1q_f32(p);
+}
+static inline void store(float* p, f32x4 v) {
+    vst1q_f32(p, v);
+}
+static inline f32x4 splat(float f) {
+    return vdupq_n_f32(f);
+}
+static inline f32x4 add(f32x4 a, f32x4 b) {
+    return vaddq_f32(a, b);
+}
+static inline f32x4 sub(f32x4 a, f32x4 b) {
+    return vsubq_f32(a, b);
+}
+static inline f32x4 mul(f32x4 a, f32x4 b) {
+    return vmulq_f32(a, b);
+}
+static inline f32x4 mad(f32x4 a, f32x4 b, f32x4 c) {
+    return vmlaq_f32(c, a, b);
+}
+static inline f32x4 min(f32x4 a, f32x4 b) {
+    return vminq_f32(a, b);
+}
+static inline f32x4 max(f32x4 a, f32x4 b) {
+    return vmaxq_f32(a, b);
+}
+static inline m32x4 greater(f32x4 a, f32x4 b) {
+    return vcgtq_f32(a, b);
+}
+static inline f32x4 select(m32x4 m, f32x4 a, f32x4 b) {
+    return vbslq_f32(m, a, b);
+}
+
+static inline i32x4 isplat(int32_t i) {
+    return vdupq_n_s32(i);
+}
+static inline i32x4 iadd(i32x4 a, i32x4 b) {
+    return vaddq_s32(a, b);
+}
+static inline i32x4 isub(i32x4 a, i32x4 b) {
+    return vsubq_s32(a, b);
+}
+static inline i32x4 iand(i32x4 a, i32x4 b) {
+    return vandq_s32(a, b);
+}
+static inline i32x4 ior(i32x4 a, i32x4 b) {
+    return vorrq_s32(a, b);
+}
+static inline i32x4 shr23(i32x4 a) {
+    return vshrq_n_s32(a, 23);
+}
+static inline i32x4 shl23(i32x4 a) {
+    return vshlq_n_s32(a, 23);
+}
+static inline i32x4 bits(f32x4 a) {
+    return vreinterpretq_s32_f32(a);
+}
+static inline f32x4 fromBits(i32x4 a) {
+    return vreinterpretq_f32_s32(a);
+}
+static inline i32x4 truncate(f32x4 a) {
+    return vcvtq_s32_f32(a);
+}
+static inline f32x4 convert(i32x4 a) {
+    return vcvtq_f32_s32(a);
+}
+
+static inline void storeInt(int32_t* p, i32x4 v) {
+    vst1q_s32(p, v);
+}
+
+#elif defined(SIMD_SSE2)
+
+typedef __m128 f32x4;
+typedef __m128i i32x4;
+typedef __m128 m32x4;
+
+static inline f32x4 load(const float* p) {
+    return _mm_loadu_ps(p);
+}
+static inline void store(float* p, f32x4 v) {
+    _mm_storeu_ps(p, v);
+}
+static inline f32x4 splat(float f) {
+    return _mm_set1_ps(f);
+}
+static inline f32x4 add(f32x4 a, f32x4 b) {
+    return _mm_add_ps(a, b);
+}
+static inline f32x4 sub(f32x4 a, f32x4 b) {
+    return _mm_sub_ps(a, b);
+}
+static inline f32x4 mul(f32x4 a, f32x4 b) {
+    return _mm_mul_ps(a, b);
+}
+static inline f32x4 mad(f32x4 a, f32x4 b, f32x4 c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+static inline f32x4 min(f32x4 a, f32x4 b) {
+    return _mm_min_ps(a, b);
+}
+static inline f32x4 max(f32x4 a, f32x4 b) {
+    return _mm_max_ps(a, b);
+}
+static inline m32x4 greater(f32x4 a, f32x4 b) {
+    return _mm_cmpgt_ps(a, b);
+}
+static inline f32x4 select(m32x4 m, f32x4 a, f32x4 b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+static inline i32x4 isplat(int32_t i) {
+    return _mm_set1_epi32(i);
+}
+static inline i32x4 iadd(i32x4 a, i32x4 b) {
+    return _mm_add_epi32(a, b);
+}
+static inline i32x4 isub(i32x4 a, i32x4 b) {
+    return _mm_sub_epi32(a, b);
+}
+static inline i32x4 iand(i32x4 a, i32x4 b) {
+    return _mm_and_si128(a, b);
+}
+static inline i32x4 ior(i32x4 a, i32x4 b) {
+    return _mm_or_si128(a, b);
+}
+static inline i32x4 shr23(i32x4 a) {
+    return _mm_srai_epi32(a, 23);
+}
+static inline i32x4 shl23(i32x4 a) {
+    return _mm_slli_epi32(a, 23);
+}
+static inline i32x4 bits(f32x4 a) {
+    return _mm_castps_si128(a);
+}
+static inline f32x4 fromBits(i32x4 a) {
+    return _mm_castsi128_ps(a);
+}
+static inline i32x4 truncate(f32x4 a) {
+    return _mm_cvttps_epi32(a);
+}
+static inline f32x4 convert(i32x4 a) {
+    return _mm_cvtepi32_ps(a);
+}
+
+static inline void storeInt(int32_t* p, i32x4 v) {
+    _mm_storeu_si128((__m128i*)p, v);
+}
+
+#else
+
+struct f32x4 {
+    float v[4];
+};
+struct i32x4 {
+    int32_t v[4];
+};
+struct m32x4 {
+    bool v[4];
+};
+
+#define SIMD_LANES(expr)            \
+    for (int i = 0; i < 4; i++) {   \
+        expr;                       \
+    }
+
+static inline f32x4 load(const float* p) {
+    f32x4 r;
+    memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+static inline void store(float* p, f32x4 v) {
+    memcpy(p, v.v, sizeof(v.v));
+}
+static inline f32x4 splat(float f) {
+    f32x4 r;
+    SIMD_LANES(r.v[i] = f);
+    return r;
+}
+static inline f32x4 add(f32x4 a, f32x4 b) {
+    SIMD_LANES(a.v[i] += b.v[i]);
+    return a;
+}
+static inline f32x4 sub(f32x4 a, f32x4 b) {
+    SIMD_LANES(a.v[i] -= b.v[i]);
+    return a;
+}
+static inline f32x4 mul(f32x4 a, f32x4 b) {
+    SIMD_LANES(a.v[i] *= b.v[i]);
+    return a;
+}
+static inline f32x4 mad(f32x4 a, f32x4 b, f32x4 c) {
+    SIMD_LANES(a.v[i] = a.v[i] * b.v[i] + c.v[i]);
+    return a;
+}
+static inline f32x4 min(f32x4 a, f32x4 b) {
+    SIMD_LANES(a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]);
+    return a;
+}
+static inline f32x4 max(f32x4 a, f32x4 b) {
+    SIMD_LANES(a.v[i] = b.v[i] > a.v[i] ? b.v[i] : a.v[i]);
+    return a;
+}
+static inline m32x4 greater(f32x4 a, f32x4 b) {
+    m32x4 m;
+    SIMD_LANES(m.v[i] = a.v[i] > b.v[i]);
+    return m;
+}
+static inline f32x4 select(m32x4 m, f32x4 a, f32x4 b) {
+    SIMD_LANES(a.v[i] = m.v[i] ? a.v[i] : b.v[i]);
+    return a;
+}
+
+static inline i32x4 isplat(int32_t n) {
+    i32x4 r;
+    SIMD_LANES(r.v[i] = n);
+    return r;
+}
+static inline i32x4 iadd(i32x4 a, i32x4 b) {
+    SIMD_LANES(a.v[i] += b.v[i]);
+    return a;
+}
+static inline i32x4 isub(i32x4 a, i32x4 b) {
+    SIMD_LANES(a.v[i] -= b.v[i]);
+    return a;
+}
+static inline i32x4 iand(i32x4 a, i32x4 b) {
+    SIMD_LANES(a.v[i] &= b.v[i]);
+    return a;
+}
+static inline i32x4 ior(i32x4 a, i32x4 b) {
+    SIMD_LANES(a.v[i] |= b.v[i]);
+    return a;
+}
+static inline i32x4 shr23(i32x4 a) {
+    SIMD_LANES(a.v[i] >>= 23);
+    return a;
+}
+static inline i32x4 shl23(i32x4 a) {
+    SIMD_LANES(a.v[i] = (int32_t)((uint32_t)a.v[i] << 23));
+    return a;
+}
+static inline i32x4 bits(f32x4 a) {
+    i32x4 r;
+    memcpy(r.v, a.v, sizeof(r.v));
+    return r;
+}
+static inline f32x4 fromBits(i32x4 a) {
+    f32x4 r;
+    memcpy(r.v, a.v, sizeof(r.v));
+    return r;
+}
+static inline i32x4 truncate(f32x4 a) {
+    i32x4 r;
+    SIMD_LANES(r.v[i] = (int32_t)a.v[i]);
+    return r;
+}
+static inline f32x4 convert(i32x4 a) {
+    f32x4 r;
+    SIMD_LANES(r.v[i] = (float)a.v[i]);
+    return r;
+}
+
+static inline void storeInt(int32_t* p, i32x4 v) {
+    memcpy(p, v.v, sizeof(v.v));
+}
+
+#undef SIMD_LANES
+
+#endif
+
+static inline f32x4 clamp(f32x4 v, f32x4 lo, f32x4 hi) {
+    return min(max(v, lo), hi);
+}
+
+static inline f32x4 floor(f32x4 v) {
+    f32x4 t = convert(truncate(v));
+    return sub(t, select(greater(t, v), splat(1.0f), splat(0.0f)));
+}
+
+// log2 for positive normal inputs, max error ~5e-6
+static inline f32x4 log2(f32x4 x) {
+    i32x4 b = bits(x);
+    f32x4 e = convert(isub(shr23(iand(b, isplat(0x7f800000))), isplat(127)));
+    f32x4 t = sub(fromBits(ior(iand(b, isplat(0x007fffff)), isplat(0x3f800000))), splat(1.0f));
+
+    f32x4 p = splat(-0.0260617976f);
+    p = mad(p, t, splat(0.121902014f));
+    p = mad(p, t, splat(-0.277352926f));
+    p = mad(p, t, splat(0.456888664f));
+    p = mad(p, t, splat(-0.717897279f));
+    p = mad(p, t, splat(1.44251696f));
+    return mad(p, t, e);
+}
+
+// 2^x, inputs are clamped to the normal float range
+static inline f32x4 exp2(f32x4 x) {
+    x = clamp(x, splat(-126.0f), splat(127.0f));
+    f32x4 fi = floor(x);
+    f32x4 f = sub(x, fi);
+
+    f32x4 p = splat(0.00187670843f);
+    p = mad(p, f, splat(0.00898881279f));
+    p = mad(p, f, splat(0.05582829f));
+    p = mad(p, f, splat(0.24015316f));
+    p = mad(p, f, splat(0.693152748f));
+    p = mad(p, f, splat(1.0f));
+
+    i32x4 scale = shl23(iadd(truncate(fi), isplat(127)));
+    return mul(p, fromBits(scale));
+}
+
+// x^y for x in (0, inf), y > 0
+static inline f32x4 pow(f32x4 x, f32x4 y) {
+    return exp2(mul(log2(max(x, splat(1.0e-30f))), y));
+}
+};
+};
+
+#endif
@@ -0,0 +1,194 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "LiveDisplay-StatePage"
+#include <utils/Log.h>
+
+#include "StatePage.h"
+#include "Utils.h"
+
+#define STATE_PAGE_MAGIC 0x4750444c  // "LDPG"
+#define STATE_PAGE_VERSION 1
+
+// A write is a few dozen bytes, so this is only hit if the writer died
+#define STATE_PAGE_READ_ATTEMPTS 10000
+
+namespace android {
+
+struct state_page {
+    uint32_t magic;
+    uint32_t version;
+    SeqLock<state_record> state;
+};
+
+StatePage::~StatePage() {
+    unmap();
+}
+
+void StatePage::unmap() {
+    if (mPage != NULL) {
+        munmap(mPage, sizeof(state_page));
+        mPage = NULL;
+    }
+    if (mFd >= 0) {
+        // Drops the writer lock too
+        close(mFd);
+        mFd = -1;
+    }
+    mWritable = false;
+}
+
+static void pagePath(char* path, size_t len) {
+    snprintf(path, len, "%s/%s", LOCAL_STORAGE_PATH, STATE_PAGE_FILE);
+}
+
+status_t StatePage::openForWrite() {
+    if (mPage != NULL && mWritable) {
+        return OK;
+    }
+
+    char path[PATH_MAX];
+    pagePath(path, sizeof(path));
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    // Held for as long as the page stays open
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        status_t rc = errno == EWOULDBLOCK ? WOULD_BLOCK : -errno;
+        close(fd);
+        if (rc == WOULD_BLOCK) {
+            ALOGD("Another process writes the state page, mapping it read only");
+            openForRead();
+        }
+        return rc;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (st.st_size != sizeof(state_page) &&
+            ftruncate(fd, sizeof(state_page)) < 0)) {
+        status_t rc = -errno;
+        close(fd);
+        return rc;
+    }
+
+    void* addr = mmap(NULL, sizeof(state_page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        status_t rc = -errno;
+        close(fd);
+        return rc;
+    }
+
+    // Taking over from a writer which went away
+    unmap();
+    mPage = static_cast<state_page*>(addr);
+    mFd = fd;
+    mWritable = true;
+
+    // First writer, or a layout from another version
+    if (mPage->magic != STATE_PAGE_MAGIC || mPage->version != STATE_PAGE_VERSION) {
+        new (&mPage->state) SeqLock<state_record>();
+        mPage->state.write(state_record());
+        mPage->version = STATE_PAGE_VERSION;
+        mPage->magic = STATE_PAGE_MAGIC;
+    } else {
+        // A previous writer may have died in the middle of a write
+        mPage->state.repair(state_record());
+    }
+    return OK;
+}
+
+status_t StatePage::openForRead() {
+    if (mPage != NULL) {
+        return OK;
+    }
+
+    char path[PATH_MAX];
+    pagePath(path, sizeof(path));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    void* addr = mmap(NULL, sizeof(state_page), PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        status_t rc = -errno;
+        close(fd);
+        return rc;
+    }
+
+    mPage = static_cast<state_page*>(addr);
+    mFd = fd;
+    mWritable = false;
+    return OK;
+}
+
+void StatePage::publish(const DisplayState& state) {
+    if (mPage == NULL || !mWritable) {
+        return;
+    }
+
+    state_record r;
+    memset(&r, 0, sizeof(r));
+    r.features = state.features;
+    r.modeId = state.modeId;
+    r.colorBalance = state.colorBalance;
+    r.hue = state.pictureAdjustment.hue;
+    r.saturation = state.pictureAdjustment.saturation;
+    r.intensity = state.pictureAdjustment.intensity;
+    r.contrast = state.pictureAdjustment.contrast;
+    r.saturationThreshold = state.pictureAdjustment.saturationThreshold;
+    r.outdoorMode = state.outdoorMode;
+    r.adaptiveBacklight = state.adaptiveBacklight;
+
+    mPage->state.write(r);
+}
+
+status_t StatePage::read(DisplayState& state) {
+    if (mPage == NULL) {
+        return NO_INIT;
+    }
+    if (mPage->magic != STATE_PAGE_MAGIC || mPage->version != STATE_PAGE_VERSION) {
+        return BAD_TYPE;
+    }
+
+    state_record r;
+    if (!mPage->state.tryRead(r, STATE_PAGE_READ_ATTEMPTS)) {
+        ALOGW("State page is stuck in a write");
+        return WOULD_BLOCK;
+    }
+    state.features = r.features;
+    state.modeId = r.modeId;
+    state.colorBalance = r.colorBalance;
+    state.pictureAdjustment = HSIC(r.hue, r.saturation, r.intensity, r.contrast,
+                                   r.saturationThreshold);
+    state.outdoorMode = r.outdoorMode;
+    state.adaptiveBacklight = r.adaptiveBacklight;
+    return OK;
+}
+};
@@ -0,0 +1,74 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_STATEPAGE_H
+#define CYNGN_STATEPAGE_H
+
+#include <utils/Errors.h>
+
+#include "SeqLock.h"
+#include "Types.h"
+
+#define STATE_PAGE_FILE "livedisplay_state_page"
+
+namespace android {
+
+struct state_record {
+    uint32_t features;
+    int32_t modeId;
+    int32_t colorBalance;
+    int32_t hue;
+    float saturation;
+    float intensity;
+    float contrast;
+    float saturationThreshold;
+    uint8_t outdoorMode;
+    uint8_t adaptiveBacklight;
+};
+
+struct state_page;
+
+/*
+ * Current display state published in a small shared file mapping, so
+ * any process can take a snapshot without going through its own
+ * backend or the LiveDisplay lock. Readers never block, and give up
+ * with WOULD_BLOCK if a writer died halfway through a write. A single
+ * process writes: openForWrite() takes an exclusive flock() which is
+ * held until the page is closed, and the next writer repairs a write
+ * left halfway. Anyone else gets WOULD_BLOCK and the page read only.
+ */
+class StatePage {
+  public:
+    StatePage() : mPage(NULL), mFd(-1), mWritable(false) {
+    }
+    ~StatePage();
+
+    status_t openForWrite();
+    status_t openForRead();
+
+    void publish(const DisplayState& state);
+    status_t read(DisplayState& state);
+
+  private:
+    void unmap();
+
+    state_page* mPage;
+    int mFd;
+    bool mWritable;
+};
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LOG_TAG "LiveDisplay-Sysfs"
+#include <utils/Log.h>
+
+#include "SysfsBackend.h"
+
+namespace android {
+
+status_t SysfsNode::open(const char* path) {
+    if (mFd >= 0) {
+        return OK;
+    }
+    mFd = TEMP_FAILURE_RETRY(::open(path, O_RDWR | O_CLOEXEC));
+    if (mFd < 0) {
+        return -errno;
+    }
+    return OK;
+}
+
+void SysfsNode::close() {
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+status_t SysfsNode::read(int32_t& value) {
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+
+    // sysfs attributes are read in one go from the start
+    char buf[32];
+    ssize_t len = TEMP_FAILURE_RETRY(pread(mFd, buf, sizeof(buf) - 1, 0));
+    if (len <= 0) {
+        return len < 0 ? -errno : NOT_ENOUGH_DATA;
+    }
+    buf[len] = '\0';
+    value = atoi(buf);
+    return OK;
+}
+
+status_t SysfsNode::write(int32_t value) {
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%d\n", value);
+    ssize_t written = TEMP_FAILURE_RETRY(pwrite(mFd, buf, len, 0));
+    if (written < 0) {
+        return -errno;
+    }
+    if (written != len) {
+        // errno isn't set for a short write
+        return -EIO;
+    }
+    return OK;
+}
+
+//----------------------------------------------------------------------------/
+
+bool SysfsBackend::isPresent() {
+    return access(FB0_CABC_NODE, W_OK) == 0 || access(FB0_HBM_NODE, W_OK) == 0 ||
+           access(FB0_SRE_NODE, W_OK) == 0;
+}
+
+status_t SysfsBackend::initialize() {
+    mCabc.open(FB0_CABC_NODE);
+
+    if (mOutdoor.open(FB0_HBM_NODE) == OK) {
+        mOutdoorValue = 1;
+    } else if (mOutdoor.open(FB0_SRE_NODE) == OK) {
+        mOutdoorValue = 2;
+    }
+
+    if (!mCabc.isOpen() && !mOutdoor.isOpen()) {
+        return NO_INIT;
+    }
+    return OK;
+}
+
+status_t SysfsBackend::deinitialize() {
+    mCabc.close();
+    mOutdoor.close();
+    return OK;
+}
+
+bool SysfsBackend::hasFeature(Feature feature) {
+    switch (feature) {
+        case Feature::ADAPTIVE_BACKLIGHT:
+            return mCabc.isOpen();
+        case Feature::OUTDOOR_MODE:
+            return mOutdoor.isOpen();
+        default:
+            return false;
+    }
+}
+
+status_t SysfsBackend::setAdaptiveBacklightEnabled(bool enabled) {
+    return mCabc.write(enabled ? 1 : 0);
+}
+
+bool SysfsBackend::isAdaptiveBacklightEnabled() {
+    int32_t value = 0;
+    return mCabc.read(value) == OK && value > 0;
+}
+
+status_t SysfsBackend::setOutdoorModeEnabled(bool enabled) {
+    return mOutdoor.write(enabled ? mOutdoorValue : 0);
+}
+
+bool SysfsBackend::isOutdoorModeEnabled() {
+    int32_t value = 0;
+    return mOutdoor.read(value) == OK && value > 0;
+}
+};
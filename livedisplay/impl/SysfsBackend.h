@@ -0,0 +1,132 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_SYSFSBACKEND_H
+#define CYNGN_SYSFSBACKEND_H
+
+#include <LiveDisplayBackend.h>
+
+#define FB0_CABC_NODE "/sys/class/graphics/fb0/cabc"
+#define FB0_HBM_NODE "/sys/class/graphics/fb0/hbm"
+#define FB0_SRE_NODE "/sys/class/graphics/fb0/sre"
+
+namespace android {
+
+/*
+ * An integer sysfs node which is kept open. Every read and write goes to
+ * the node, as the driver resets it when the panel is blanked.
+ */
+class SysfsNode {
+  public:
+    SysfsNode() : mFd(-1) {
+    }
+    ~SysfsNode() {
+        close();
+    }
+
+    status_t open(const char* path);
+    void close();
+
+    bool isOpen() const {
+        return mFd >= 0;
+    }
+
+    status_t read(int32_t& value);
+    status_t write(int32_t value);
+
+  private:
+    int mFd;
+};
+
+/*
+ * Backend for the panel knobs exposed by the framebuffer driver:
+ * adaptive backlight (cabc) and outdoor mode (hbm, or sre where there
+ * is no hbm). Works on its own, or behind a platform backend through
+ * ChainedBackend for the features the platform one lacks.
+ */
+class SysfsBackend : public LiveDisplayBackend {
+  public:
+    SysfsBackend() : mOutdoorValue(0) {
+    }
+
+    // Whether any of the nodes exist on this device
+    static bool isPresent();
+
+    virtual status_t initialize();
+    virtual status_t deinitialize();
+    virtual bool hasFeature(Feature feature);
+
+    // Each feature has a node to itself
+    virtual bool supportsConcurrentProbe() {
+        return true;
+    }
+
+    virtual status_t setAdaptiveBacklightEnabled(bool enabled);
+    virtual bool isAdaptiveBacklightEnabled();
+
+    virtual status_t setOutdoorModeEnabled(bool enabled);
+    virtual bool isOutdoorModeEnabled();
+
+    virtual status_t getColorBalanceRange(Range& /* range */) {
+        return NO_INIT;
+    }
+    virtual status_t setColorBalance(int32_t /* balance */) {
+        return NO_INIT;
+    }
+    virtual int32_t getColorBalance() {
+        return 0;
+    }
+
+    virtual status_t getDisplayModes(List<sp<DisplayMode>>& /* profiles */) {
+        return NO_INIT;
+    }
+    virtual status_t setDisplayMode(int32_t /* modeID */, bool /* makeDefault */) {
+        return NO_INIT;
+    }
+    virtual sp<DisplayMode> getCurrentDisplayMode() {
+        return nullptr;
+    }
+    virtual sp<DisplayMode> getDefaultDisplayMode() {
+        return nullptr;
+    }
+
+    virtual status_t getPictureAdjustmentRanges(HSICRanges& /* ranges */) {
+        return NO_INIT;
+    }
+    virtual status_t getPictureAdjustment(HSIC& /* hsic */) {
+        return NO_INIT;
+    }
+    virtual status_t getDefaultPictureAdjustment(HSIC& /* hsic */) {
+        return NO_INIT;
+    }
+    virtual status_t setPictureAdjustment(HSIC /* hsic */) {
+        return NO_INIT;
+    }
+
+    virtual ~SysfsBackend() {
+    }
+
+  private:
+    SysfsNode mCabc;
+    SysfsNode mOutdoor;
+
+    // Written to the outdoor node to turn it on, hbm and sre differ
+    int32_t mOutdoorValue;
+};
+};
+
+#endif
@@ -17,20 +17,39 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <signal.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 #include <cutils/sockets.h>
 
 #include "Utils.h"
 
-#define LOCAL_STORAGE_PATH "/data/misc/display"
-#define LOCAL_MODE_ID "livedisplay_mode"
-
 namespace android {
 
+struct local_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t length;
+    uint32_t crc;
+};
+
+static status_t writeFully(int fd, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t ret = TEMP_FAILURE_RETRY(write(fd, p, len));
+        if (ret <= 0) {
+            return ret < 0 ? -errno : UNKNOWN_ERROR;
+        }
+        p += ret;
+        len -= ret;
+    }
+    return OK;
+}
+
 status_t Utils::exists(const char* node) {
 
     struct stat sbuf;
@@ -71,16 +90,96 @@ status_t Utils::writeInt(const char* node, int32_t value) {
     return ret;
 }
 
-status_t Utils::readLocalModeId(int32_t* id) {
-    char buf[PATH_MAX];
-    sprintf(buf, "%s/%s", LOCAL_STORAGE_PATH, LOCAL_MODE_ID);
-    return readInt(buf, id);
+uint32_t Utils::crc32(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+status_t Utils::writeLocalFile(const char* name, uint32_t magic, uint32_t version,
+                               const void* data, size_t len) {
+    char path[PATH_MAX];
+    char tmp[PATH_MAX + 4];
+    snprintf(path, sizeof(path), "%s/%s", LOCAL_STORAGE_PATH, name);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    struct local_file_header header;
+    header.magic = magic;
+    header.version = version;
+    header.length = len;
+    header.crc = crc32(data, len);
+
+    status_t rc = writeFully(fd, &header, sizeof(header));
+    if (rc == OK) {
+        rc = writeFully(fd, data, len);
+    }
+    if (rc == OK && fsync(fd) != 0) {
+        rc = -errno;
+    }
+    close(fd);
+
+    // the rename either publishes the whole file or nothing
+    if (rc == OK && rename(tmp, path) != 0) {
+        rc = -errno;
+    }
+    if (rc != OK) {
+        unlink(tmp);
+    }
+    return rc;
 }
 
-status_t Utils::writeLocalModeId(int32_t id) {
-    char buf[PATH_MAX];
-    sprintf(buf, "%s/%s", LOCAL_STORAGE_PATH, LOCAL_MODE_ID);
-    return writeInt(buf, id);
+status_t Utils::readLocalFile(const char* name, uint32_t magic, uint32_t version, void* data,
+                              size_t len) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", LOCAL_STORAGE_PATH, name);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno == ENOENT ? NAME_NOT_FOUND : -errno;
+    }
+
+    struct stat sbuf;
+    if (fstat(fd, &sbuf) != 0) {
+        status_t rc = -errno;
+        close(fd);
+        return rc;
+    }
+    if ((size_t)sbuf.st_size != sizeof(struct local_file_header) + len) {
+        close(fd);
+        return BAD_TYPE;
+    }
+
+    void* map = mmap(NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -errno;
+    }
+
+    const struct local_file_header* header = (const struct local_file_header*)map;
+    const uint8_t* payload = (const uint8_t*)map + sizeof(*header);
+
+    status_t rc = OK;
+    if (header->magic != magic || header->version != version || header->length != len) {
+        rc = BAD_TYPE;
+    } else if (crc32(payload, len) != header->crc) {
+        rc = BAD_VALUE;
+    } else {
+        memcpy(data, payload, len);
+    }
+    munmap(map, sbuf.st_size);
+    return rc;
 }
 
 status_t Utils::sendDPPSCommand(char* buf, size_t len) {
@@ -20,6 +20,10 @@
 #include <stdlib.h>
 #include <utils/Errors.h>
 
+#include "Types.h"
+
+#define LOCAL_STORAGE_PATH "/data/misc/display"
+
 namespace android {
 
 class Utils {
@@ -34,9 +38,13 @@ public:
 
     static status_t exists(const char* node);
 
-    static status_t writeLocalModeId(int32_t id);
+    static uint32_t crc32(const void* data, size_t len);
+
+    static status_t writeLocalFile(const char* name, uint32_t magic, uint32_t version,
+                                   const void* data, size_t len);
 
-    static status_t readLocalModeId(int32_t* id);
+    static status_t readLocalFile(const char* name, uint32_t magic, uint32_t version,
+                                  void* data, size_t len);
 };
 
 };
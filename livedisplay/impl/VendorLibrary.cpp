@@ -0,0 +1,138 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <dlfcn.h>
+#include <inttypes.h>
+
+#include <cutils/properties.h>
+
+#define LOG_TAG "LiveDisplay-VendorLibrary"
+#include <utils/Log.h>
+
+#include "VendorLibrary.h"
+
+namespace android {
+
+VendorSymbol::VendorSymbol(VendorLibrary& lib, const char* name, uint32_t features)
+    : mLib(lib), mName(name), mFeatures(features), mAddr(NULL), mBound(false) {
+    mLib.mSymbols.push_back(this);
+}
+
+void VendorSymbol::bind() {
+    mLib.bind(*this);
+}
+
+VendorLibrary::~VendorLibrary() {
+    close();
+}
+
+status_t VendorLibrary::open() {
+    return open(property_get_int32("persist.livedisplay.bind_now", 0) > 0);
+}
+
+status_t VendorLibrary::open(bool bindNow) {
+    if (mHandle != NULL) {
+        return OK;
+    }
+
+    // Symbols are looked up one at a time as they are needed
+    nsecs_t start = systemTime();
+    mHandle = dlopen(mPath, RTLD_LAZY);
+    if (mHandle == NULL) {
+        ALOGE("DLOPEN failed for %s (%s)", mPath, dlerror());
+        return NO_INIT;
+    }
+    ALOGD("Opened %s in %" PRId64 "us", mPath, ns2us(systemTime() - start));
+
+    if (!bindAll(VENDOR_REQUIRED, bindNow)) {
+        ALOGE("Failed to link vendor library %s", mPath);
+        close();
+        return NO_INIT;
+    }
+    return OK;
+}
+
+void VendorLibrary::close() {
+    Mutex::Autolock _l(mLock);
+
+    if (mHandle == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < mSymbols.size(); i++) {
+        mSymbols[i]->mAddr = NULL;
+        mSymbols[i]->mBound.store(false, std::memory_order_relaxed);
+    }
+    dlclose(mHandle);
+    mHandle = NULL;
+}
+
+void VendorLibrary::bind(VendorSymbol& sym) {
+    Mutex::Autolock _l(mLock);
+
+    // Nothing to bind to until the library is opened
+    if (sym.mBound.load(std::memory_order_relaxed) || mHandle == NULL) {
+        return;
+    }
+
+    nsecs_t start = systemTime();
+    sym.mAddr = dlsym(mHandle, sym.mName);
+    mBindTime += systemTime() - start;
+    mBindCount++;
+
+    if (sym.mAddr == NULL) {
+        ALOGE("dlsym failed for %s", sym.mName);
+    }
+    sym.mBound.store(true, std::memory_order_release);
+}
+
+/*
+ * Binds the symbols tagged with any of the features, or every symbol,
+ * and logs how long that took. Returns false if one is missing.
+ */
+bool VendorLibrary::bindAll(uint32_t features, bool all) {
+    uint32_t count;
+    nsecs_t time;
+    {
+        Mutex::Autolock _l(mLock);
+        count = mBindCount;
+        time = mBindTime;
+    }
+
+    bool found = true;
+
+    for (size_t i = 0; i < mSymbols.size(); i++) {
+        VendorSymbol* sym = mSymbols[i];
+        bool wanted = features == VENDOR_REQUIRED ? sym->mFeatures == VENDOR_REQUIRED
+                                                  : (sym->mFeatures & features) != 0;
+        if (all || wanted) {
+            found &= sym->get() != NULL || !wanted;
+        }
+    }
+
+    Mutex::Autolock _l(mLock);
+    if (mBindCount != count) {
+        ALOGD("Bound %u symbols for 0x%x in %" PRId64 "us (%u of %zu so far)",
+              mBindCount - count, features, ns2us(mBindTime - time), mBindCount,
+              mSymbols.size());
+    }
+    return found;
+}
+
+bool VendorLibrary::provides(uint32_t features) {
+    return features != VENDOR_REQUIRED && bindAll(features, false);
+}
+};
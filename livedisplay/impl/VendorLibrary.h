@@ -0,0 +1,137 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_VENDORLIBRARY_H
+#define CYNGN_VENDORLIBRARY_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+
+// Symbols tagged with no features are needed by every feature
+#define VENDOR_REQUIRED 0u
+
+namespace android {
+
+class VendorLibrary;
+
+/*
+ * A symbol in a vendor library, bound with dlsym() the first time it is
+ * used. Misses are cached too, so a missing symbol is only looked up once.
+ */
+class VendorSymbol {
+  public:
+    VendorSymbol(VendorLibrary& lib, const char* name, uint32_t features);
+
+    void* get() {
+        if (!mBound.load(std::memory_order_acquire)) {
+            bind();
+        }
+        return mAddr;
+    }
+
+  private:
+    friend class VendorLibrary;
+
+    VendorSymbol(const VendorSymbol&) = delete;
+    VendorSymbol& operator=(const VendorSymbol&) = delete;
+
+    void bind();
+
+    VendorLibrary& mLib;
+    const char* mName;
+    uint32_t mFeatures;
+    void* mAddr;
+    std::atomic<bool> mBound;
+};
+
+/*
+ * Typed call through a VendorSymbol. Calling a symbol which the library
+ * doesn't have fails with NAME_NOT_FOUND instead of jumping to NULL.
+ */
+template <typename R, typename... Args>
+class VendorFunction : public VendorSymbol {
+  public:
+    VendorFunction(VendorLibrary& lib, const char* name, uint32_t features = VENDOR_REQUIRED)
+        : VendorSymbol(lib, name, features) {
+    }
+
+    R operator()(Args... args) {
+        R (*fn)(Args...) = reinterpret_cast<R (*)(Args...)>(get());
+        if (fn == NULL) {
+            return (R)NAME_NOT_FOUND;
+        }
+        return fn(args...);
+    }
+};
+
+/*
+ * A dlopen()ed vendor library and the table of symbols used from it.
+ * Backends declare their symbols as VendorFunction members next to the
+ * library, each tagged with the features which need it. Required
+ * symbols are bound when the library is opened; the rest are bound on
+ * first use, which for most of them is the feature probe.
+ *
+ * Setting persist.livedisplay.bind_now binds the whole table at open
+ * instead, to compare the two at startup.
+ */
+class VendorLibrary {
+  public:
+    explicit VendorLibrary(const char* path)
+        : mPath(path), mHandle(NULL), mBindTime(0), mBindCount(0) {
+    }
+    ~VendorLibrary();
+
+    status_t open();
+    // Binds the whole table if bindNow is set, otherwise the required symbols
+    status_t open(bool bindNow);
+    void close();
+
+    bool isOpen() const {
+        return mHandle != NULL;
+    }
+
+    // Binds every symbol the features need, false if any is missing
+    bool provides(uint32_t features);
+
+  private:
+    friend class VendorSymbol;
+
+    VendorLibrary(const VendorLibrary&) = delete;
+    VendorLibrary& operator=(const VendorLibrary&) = delete;
+
+    void bind(VendorSymbol& sym);
+    bool bindAll(uint32_t features, bool all);
+
+    const char* mPath;
+    void* mHandle;
+    std::vector<VendorSymbol*> mSymbols;
+
+    // Time spent in dlsym() so far, and how many symbols that covered
+    nsecs_t mBindTime;
+    uint32_t mBindCount;
+
+    Mutex mLock;
+};
+};
+
+#endif
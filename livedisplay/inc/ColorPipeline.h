@@ -0,0 +1,66 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_COLORPIPELINE_H
+#define CYNGN_LIVEDISPLAY_COLORPIPELINE_H
+
+#include <utils/Errors.h>
+
+#include <Types.h>
+
+namespace android {
+
+/*
+ * CPU reference for what picture adjustment and color balance do to
+ * pixels. Used for previews and for comparing against captures from
+ * the panel, it is not meant to match vendor output bit for bit.
+ *
+ * Pixels are split into luma and two chroma differences. Hue rotates
+ * the chroma plane, saturation scales chroma above the threshold,
+ * contrast and intensity act on luma, and the color balance is applied
+ * last as per-channel gains.
+ */
+class ColorPipeline {
+  public:
+    ColorPipeline();
+
+    void setPictureAdjustment(const HSIC& hsic, const HSICRanges& ranges);
+    void setColorBalance(int32_t balance, const Range& range);
+    void setGains(float red, float green, float blue);
+
+    /*
+     * Transforms an RGBA8888 buffer. Alpha is passed through and src may
+     * equal dst. Rows are split across threads; zero picks one thread
+     * per online core.
+     */
+    status_t process(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height,
+                     uint32_t stride, uint32_t threads = 0) const;
+
+  private:
+    void processRows(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t first,
+                     uint32_t last, uint32_t stride) const;
+
+    float mHueCos;
+    float mHueSin;
+    float mSaturation;
+    float mThreshold;
+    float mContrast;
+    float mIntensity;
+    float mGains[3];
+};
+};
+
+#endif
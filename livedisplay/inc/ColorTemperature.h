@@ -0,0 +1,114 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_COLORTEMPERATURE_H
+#define CYNGN_LIVEDISPLAY_COLORTEMPERATURE_H
+
+#include <algorithm>
+
+#include <Lighting.h>
+#include <Types.h>
+
+namespace android {
+
+// Kelvin range exposed to clients, and the white point which maps to
+// a color balance of zero
+#define COLOR_TEMPERATURE_MIN 1900
+#define COLOR_TEMPERATURE_MAX 10000
+#define COLOR_TEMPERATURE_NEUTRAL 6500
+#define COLOR_TEMPERATURE_STEP 100
+
+struct LightSource {
+    int32_t kelvin;
+    const int* rgb;
+};
+
+// Reference light sources, ordered by temperature
+constexpr LightSource LIGHT_SOURCES[] = {
+    {1900, CANDLE},
+    {2600, TUNGSTEN_40W},
+    {2850, TUNGSTEN_100W},
+    {3200, HALOGEN},
+    {5200, CARBON_ARC},
+    {5400, HIGH_NOON_SUN},
+    {6000, DIRECT_SUNLIGHT},
+    {7000, OVERCAST_SKY},
+    {20000, CLEAR_BLUE_SKY},
+};
+
+constexpr int NUM_LIGHT_SOURCES = sizeof(LIGHT_SOURCES) / sizeof(LIGHT_SOURCES[0]);
+
+// Blue/red skew of a light source, from -255 (red) to 255 (blue)
+constexpr int32_t warmthOf(const LightSource& l) {
+    return l.rgb[2] - l.rgb[0];
+}
+
+// Warmth at an arbitrary temperature, interpolated between the
+// light sources. Scaled by 1024 to keep the fractional part.
+constexpr int32_t warmthAt(int32_t kelvin, int i = 1) {
+    return (i >= NUM_LIGHT_SOURCES - 1 || kelvin <= LIGHT_SOURCES[i].kelvin)
+               ? warmthOf(LIGHT_SOURCES[i - 1]) * 1024 +
+                     (warmthOf(LIGHT_SOURCES[i]) - warmthOf(LIGHT_SOURCES[i - 1])) * 1024 *
+                         (kelvin - LIGHT_SOURCES[i - 1].kelvin) /
+                         (LIGHT_SOURCES[i].kelvin - LIGHT_SOURCES[i - 1].kelvin)
+               : warmthAt(kelvin, i + 1);
+}
+
+/*
+ * Maps color temperatures onto the unitless color balance range of a
+ * backend. The curve follows the reference light sources: the neutral
+ * white point maps to zero, COLOR_TEMPERATURE_MIN to the lower end of
+ * the range and COLOR_TEMPERATURE_MAX to the upper end.
+ *
+ * The table is rebuilt whenever the backend range changes, so lookups
+ * are a clamp, a multiply and a single interpolation.
+ */
+class ColorTemperature {
+  public:
+    static constexpr int NUM_STEPS =
+        (COLOR_TEMPERATURE_MAX - COLOR_TEMPERATURE_MIN) / COLOR_TEMPERATURE_STEP + 1;
+
+    ColorTemperature() {
+        setRange(Range());
+    }
+
+    void setRange(const Range& range);
+
+    bool isValid() const {
+        return mRange.min != 0 || mRange.max != 0;
+    }
+
+    int32_t toBalance(int32_t kelvin) const {
+        int32_t offset = std::min(std::max(kelvin, (int32_t)COLOR_TEMPERATURE_MIN),
+                                  (int32_t)COLOR_TEMPERATURE_MAX) -
+                         COLOR_TEMPERATURE_MIN;
+        int32_t i = std::min(offset / COLOR_TEMPERATURE_STEP, NUM_STEPS - 2);
+        int32_t frac = offset - i * COLOR_TEMPERATURE_STEP;
+        return mBalance[i] + (mBalance[i + 1] - mBalance[i]) * frac / COLOR_TEMPERATURE_STEP;
+    }
+
+    int32_t toKelvin(int32_t balance) const;
+
+    // Channel gains which shift the neutral white point to kelvin
+    static void toGains(int32_t kelvin, float gains[3]);
+
+  private:
+    Range mRange;
+    int32_t mBalance[NUM_STEPS];
+};
+};
+
+#endif
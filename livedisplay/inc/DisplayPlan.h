@@ -0,0 +1,70 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_DISPLAYPLAN_H
+#define CYNGN_LIVEDISPLAY_DISPLAYPLAN_H
+
+#include <Types.h>
+
+#define MAX_PLAN_OPS 5
+
+namespace android {
+
+/*
+ * Ordered list of backend operations which takes the display from one
+ * state to another. Settings already in place are skipped, and the mode
+ * always goes first since applying it resets the picture adjustment.
+ *
+ * Only the settings flagged in the target are touched. Settings not
+ * flagged in the current state are unknown and are always applied.
+ */
+class DisplayPlan {
+  public:
+    DisplayPlan() : mSize(0), mSkipped(0) {
+    }
+
+    void build(const DisplayState& current, const DisplayState& target);
+
+    uint32_t size() const {
+        return mSize;
+    }
+
+    // Settings requested by the target which needed no operation
+    uint32_t skipped() const {
+        return mSkipped;
+    }
+
+    Feature at(uint32_t i) const {
+        return mOps[i];
+    }
+
+    const DisplayState& target() const {
+        return mTarget;
+    }
+
+  private:
+    void add(Feature f) {
+        mOps[mSize++] = f;
+    }
+
+    DisplayState mTarget;
+    Feature mOps[MAX_PLAN_OPS];
+    uint32_t mSize;
+    uint32_t mSkipped;
+};
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_GAMMALUT_H
+#define CYNGN_LIVEDISPLAY_GAMMALUT_H
+
+#include <utils/Errors.h>
+
+#include <Types.h>
+
+#define GAMMA_LUT_MAX_SIZE 4096
+
+namespace android {
+
+class LutParams {
+  public:
+    LutParams() : contrast(0.0f), intensity(0.0f) {
+        for (int i = 0; i < 3; i++) {
+            gamma[i] = 1.0f;
+            gain[i] = 1.0f;
+        }
+    }
+
+    /*
+     * Picks up intensity and contrast from a picture adjustment. Hue and
+     * saturation mix channels and can't be expressed as 1D curves.
+     */
+    void setPictureAdjustment(const HSIC& hsic, const HSICRanges& ranges) {
+        intensity = ranges.intensity.normalize(hsic.intensity);
+        contrast = ranges.contrast.normalize(hsic.contrast);
+    }
+
+    float gamma[3];     // per-channel exponent, 1.0 is linear
+    float gain[3];      // per-channel output scale
+    float contrast;     // [-1, 1], slope around mid-gray
+    float intensity;    // [-1, 1], offset of up to half the output range
+};
+
+/*
+ * Per-channel 1D lookup table, as programmed into the PGC/ARGC blocks.
+ * Outputs have the same precision as the table size, so a 1024 entry
+ * table holds 10-bit values.
+ */
+class GammaLut {
+  public:
+    enum Channel { RED = 0, GREEN, BLUE, NUM_CHANNELS };
+
+    GammaLut() : mSize(0) {
+    }
+
+    // size must be one of 256, 1024 or 4096
+    status_t generate(size_t size, const LutParams& params);
+
+    size_t size() const {
+        return mSize;
+    }
+
+    uint16_t maxValue() const {
+        return mSize > 0 ? mSize - 1 : 0;
+    }
+
+    const uint16_t* channel(Channel c) const {
+        return mTable[c];
+    }
+
+  private:
+    size_t mSize;
+    uint16_t mTable[NUM_CHANNELS][GAMMA_LUT_MAX_SIZE];
+};
+};
+
+#endif
@@ -22,29 +22,29 @@
 namespace android {
 
 // Natural light sources
-const int CANDLE[] = {255, 147, 41};
-const int TUNGSTEN_40W[] = {255, 197, 143};
-const int TUNGSTEN_100W[] = {255, 214, 170};
-const int HALOGEN[] = {255, 241, 224};
-const int CARBON_ARC[] = {255, 250, 244};
-const int HIGH_NOON_SUN[] = {255, 255, 251};
-const int DIRECT_SUNLIGHT[] = {255, 255, 255};
-const int OVERCAST_SKY[] = {201, 226, 255};
-const int CLEAR_BLUE_SKY[] = {64, 156, 255};
+constexpr int CANDLE[] = {255, 147, 41};
+constexpr int TUNGSTEN_40W[] = {255, 197, 143};
+constexpr int TUNGSTEN_100W[] = {255, 214, 170};
+constexpr int HALOGEN[] = {255, 241, 224};
+constexpr int CARBON_ARC[] = {255, 250, 244};
+constexpr int HIGH_NOON_SUN[] = {255, 255, 251};
+constexpr int DIRECT_SUNLIGHT[] = {255, 255, 255};
+constexpr int OVERCAST_SKY[] = {201, 226, 255};
+constexpr int CLEAR_BLUE_SKY[] = {64, 156, 255};
 
 // Fluorescent lights
-const int WARM[] = {255, 244, 229};
-const int STANDARD[] = {244, 255, 250};
-const int COOL_WHITE[] = {212, 235, 255};
-const int FULL_SPECTRUM[] = {255, 244, 242};
-const int GROW_LIGHT[] = {255, 239, 247};
-const int BLACK_LIGHT[] = {167, 0, 255};
+constexpr int WARM[] = {255, 244, 229};
+constexpr int STANDARD[] = {244, 255, 250};
+constexpr int COOL_WHITE[] = {212, 235, 255};
+constexpr int FULL_SPECTRUM[] = {255, 244, 242};
+constexpr int GROW_LIGHT[] = {255, 239, 247};
+constexpr int BLACK_LIGHT[] = {167, 0, 255};
 
 // Gas lights
-const int MERCURY_VAPOR[] = {216, 247, 255};
-const int SODIUM_VAPOR[] = {255, 209, 178};
-const int METAL_HALIDE[] = {242, 252, 255};
-const int HP_SODIUM[] = {255, 183, 76};
+constexpr int MERCURY_VAPOR[] = {216, 247, 255};
+constexpr int SODIUM_VAPOR[] = {255, 209, 178};
+constexpr int METAL_HALIDE[] = {242, 252, 255};
+constexpr int HP_SODIUM[] = {255, 183, 76};
 };
 
 #endif
@@ -17,15 +17,45 @@
 #ifndef CYNGN_LIVEDISPLAYBASE_H
 #define CYNGN_LIVEDISPLAYBASE_H
 
+#include <stdint.h>
+
 #include <utils/Log.h>
 #include <utils/Mutex.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
 
+#include "BackendExecutor.h"
+#include "ColorTemperature.h"
+#include "DisplayPlan.h"
 #include "LiveDisplayBackend.h"
+#include "ProfileStore.h"
+#include "SeqLock.h"
+#include "SettingArbiter.h"
+#include "StatePage.h"
 #include "Types.h"
 
 namespace android {
 
+/*
+ * What the backend supports and the ranges it reported, none of which
+ * can change while it stays initialized. Published by connect() and
+ * read without taking the LiveDisplay lock.
+ */
+class Capabilities {
+  public:
+    Capabilities()
+        : valid(false), generation(0), features(0), ranges(0), colorTemperature(false) {
+    }
+
+    bool valid;
+    uint32_t generation;  // bumped every time the backend is brought up
+    uint32_t features;
+    uint32_t ranges;  // features whose range below was reported
+    Range colorBalance;
+    HSICRanges pictureAdjustment;
+    bool colorTemperature;
+};
+
 class LiveDisplay : public LiveDisplayAPI, public Singleton<LiveDisplay> {
     friend class Singleton;
 
@@ -34,10 +64,78 @@ class LiveDisplay : public LiveDisplayAPI, public Singleton<LiveDisplay> {
         return connect() && (mFeatures & (uint32_t)f);
     }
 
-    uint32_t getSupportedFeatures();
+    virtual uint32_t getSupportedFeatures();
 
     void reset();
 
+    status_t setGammaLut(const GammaLut& lut);
+
+    /*
+     * Moves the display to the settings flagged in target with as few
+     * backend calls as possible. Unsupported settings are ignored, and
+     * nothing is persisted. Settings held by a client layer keep the
+     * layer's value, as they do for profiles.
+     */
+    status_t applyState(const DisplayState& target);
+
+    /*
+     * Profiles are full display states registered up front, so that
+     * switching to one is a single call.
+     */
+    status_t setProfile(int32_t id, const DisplayState& state);
+    status_t removeProfile(int32_t id);
+    status_t applyProfile(int32_t id);
+
+    /*
+     * Clients sharing the display each hold a layer of settings, and the
+     * one with the highest priority decides each setting. The user's own
+     * settings sit below every layer. The backend is only touched when
+     * the resolved state changes.
+     */
+    status_t setClientLayer(int32_t client, int32_t priority, const DisplayState& state);
+    status_t removeClientLayer(int32_t client);
+    status_t getClientStats(int32_t client, ClientStats& stats);
+
+    /*
+     * Reads every supported setting back from the backend under a single
+     * lock, so the values are consistent with each other. Only the
+     * settings which could be read are flagged in state.
+     */
+    status_t getState(DisplayState& state, int32_t& kelvin);
+
+    void getStats(LiveDisplayStats& stats);
+
+    // Whether a backend call is stuck, and how often that happened
+    void getHealth(BackendHealth& health);
+
+    /*
+     * While the panel is off, setters only record their values and the
+     * backend is left alone. Everything recorded goes out in one plan
+     * when it turns back on, and whatever the backend failed to take is
+     * kept for the next call with on set.
+     */
+    status_t setScreenOn(bool on);
+    bool isScreenOn();
+
+    // Follows the fb0 blank events, only returns if the node fails
+    void monitorScreenState();
+
+    // Changes whenever the list of display modes may have changed
+    uint32_t getDisplayModesGeneration();
+
+    /*
+     * Lock free and never connect or call the backend, so they suit
+     * critical natives. Each returns the last known value, or
+     * PEEK_UNKNOWN if there is none yet. connect() reads them in ahead
+     * of time.
+     */
+    static const int32_t PEEK_UNKNOWN = INT32_MIN;
+    int32_t peekSupportedFeatures();
+    int32_t peekColorBalance();
+    int32_t peekColorTemperature();
+    int32_t peekOutdoorMode();
+    int32_t peekAdaptiveBacklight();
+
     virtual status_t setAdaptiveBacklightEnabled(bool enabled);
     virtual bool isAdaptiveBacklightEnabled();
 
@@ -48,7 +146,12 @@ class LiveDisplay : public LiveDisplayAPI, public Singleton<LiveDisplay> {
     virtual status_t setColorBalance(int32_t balance);
     virtual int32_t getColorBalance();
 
+    virtual status_t getColorTemperatureRange(Range& range);
+    virtual status_t setColorTemperature(int32_t kelvin);
+    virtual int32_t getColorTemperature();
+
     virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles);
+    status_t getDisplayModeRecords(DisplayModeRecord* records, size_t capacity, size_t& count);
     virtual status_t setDisplayMode(int32_t modeID, bool makeDefault);
     virtual sp<DisplayMode> getCurrentDisplayMode();
     virtual sp<DisplayMode> getDefaultDisplayMode();
@@ -67,11 +170,30 @@ class LiveDisplay : public LiveDisplayAPI, public Singleton<LiveDisplay> {
 
     bool check(Feature f);
     bool connect();
-    void error(const char* msg = NULL, ...);
+    void error(status_t rc, const char* msg);
+    bool reconnect();
+    void backoff();
+    template <typename F>
+    status_t call(F op, uint32_t timeoutMs);
+    template <typename F>
+    status_t invoke(F op);
+    template <typename T, typename F>
+    status_t fetch(T& out, F op);
+    status_t fetchColorBalance(int32_t& balance);
     bool isConnected() {
         return mConnected;
     }
 
+    int32_t toColorTemperature(int32_t balance);
+
+    void publishCapabilities();
+    bool getCapabilities(Capabilities& caps);
+
+    void restoreState();
+    void primeShadow();
+    void saveState();
+    status_t applyPlan(const DisplayPlan& plan, uint32_t& failed);
+
     void addFeature(Feature f) {
         mFeatures |= (uint32_t)f;
     };
@@ -79,7 +201,57 @@ class LiveDisplay : public LiveDisplayAPI, public Singleton<LiveDisplay> {
         mFeatures = 0;
     };
 
+    // Last value set through each setter, persisted across reboots
+    DisplayState mState;
+
+    // What the hardware was last set to, or unknown if not flagged
+    DisplayState mCurrent;
+
+    // Settings requested while the panel was off, not applied yet
+    DisplayState mDeferred;
+    bool mScreenOn;
+    bool deferWhileOff(const DisplayState& change);
+
+    // mCurrent with mDeferred on top, for the getters to read without the lock
+    SeqLock<DisplayState> mCurrentShadow;
+    // Color temperature of mCurrentShadow, -1 if unknown
+    SeqLock<int32_t> mColorTemperatureShadow;
+    void publishCurrent();
+    void updateShadow(const DisplayState& visible);
+
+    // The same for other processes, written only once this one owns the backend
+    StatePage mStatePage;
+
+    // Connecting is held off until mRetryAt after repeated failures
+    uint32_t mBackoffMs;
+    nsecs_t mRetryAt;
+
+    ProfileStore mProfiles;
+
+    SettingArbiter mArbiter;
+    status_t applyResolved(int32_t client, uint32_t touched);
+    bool isLayered(const DisplayState& change);
+    DisplayState withLayers(const DisplayState& state);
+
+    LiveDisplayStats mStats;
+
+    SeqLock<Capabilities> mCapabilities;
+    uint32_t mGeneration;
+
+    // Display modes as listed for mModeRecordsGeneration, 0 if not listed yet
+    DisplayModeRecord mModeRecords[MAX_DISPLAY_MODES];
+    size_t mModeRecordCount;
+    uint32_t mModeRecordsGeneration;
+
+    ColorTemperature mColorTemperature;
+    int32_t mColorTemperatureKelvin;
+
     LiveDisplayBackend* mBackend;
+
+    // Every backend call goes through here, with a deadline
+    BackendExecutor mExecutor;
+    uint32_t mRecoveries;
+
     Mutex mLock;
 };
 };
@@ -26,6 +26,9 @@ namespace android {
 
 class LiveDisplayAPI {
   public:
+    // Bitmask of the supported Features
+    virtual uint32_t getSupportedFeatures() = 0;
+
     virtual status_t setAdaptiveBacklightEnabled(bool enabled) = 0;
     virtual bool isAdaptiveBacklightEnabled() = 0;
 
@@ -36,6 +39,10 @@ class LiveDisplayAPI {
     virtual status_t setColorBalance(int32_t balance) = 0;
     virtual int32_t getColorBalance() = 0;
 
+    virtual status_t getColorTemperatureRange(Range& range) = 0;
+    virtual status_t setColorTemperature(int32_t kelvin) = 0;
+    virtual int32_t getColorTemperature() = 0;
+
     virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles) = 0;
     virtual status_t setDisplayMode(int32_t modeID, bool makeDefault) = 0;
     virtual sp<DisplayMode> getCurrentDisplayMode() = 0;
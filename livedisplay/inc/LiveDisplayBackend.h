@@ -17,8 +17,11 @@
 #ifndef CYNGN_LIVEDISPLAYBACKEND_H
 #define CYNGN_LIVEDISPLAYBACKEND_H
 
+#include <string.h>
+
 #include <utils/Errors.h>
 
+#include <GammaLut.h>
 #include <LiveDisplayAPI.h>
 
 namespace android {
@@ -29,6 +32,62 @@ class LiveDisplayBackend : public LiveDisplayAPI {
     virtual status_t deinitialize() = 0;
     virtual bool hasFeature(Feature feature) = 0;
 
+    // Whether hasFeature() may be called for several features at once
+    virtual bool supportsConcurrentProbe() {
+        return false;
+    }
+
+    virtual uint32_t getSupportedFeatures() {
+        uint32_t features = 0;
+        for (uint32_t f = 1; f <= (uint32_t)Feature::MAX; f <<= 1) {
+            if (hasFeature((Feature)f)) {
+                features |= f;
+            }
+        }
+        return features;
+    }
+
+    // Color temperature is mapped onto the color balance by LiveDisplay
+    virtual status_t getColorTemperatureRange(Range& /* range */) {
+        return INVALID_OPERATION;
+    }
+    virtual status_t setColorTemperature(int32_t /* kelvin */) {
+        return INVALID_OPERATION;
+    }
+    virtual int32_t getColorTemperature() {
+        return -1;
+    }
+
+    /*
+     * Lists up to capacity modes into records, with count set to the
+     * number filled. Backends override this to skip the allocations
+     * made by getDisplayModes().
+     */
+    virtual status_t getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                           size_t& count) {
+        List<sp<DisplayMode>> modes;
+        count = 0;
+
+        status_t rc = getDisplayModes(modes);
+        if (rc != OK) {
+            return rc;
+        }
+        for (List<sp<DisplayMode>>::iterator it = modes.begin();
+                it != modes.end() && count < capacity; ++it) {
+            DisplayModeRecord& r = records[count++];
+            r.id = (*it)->id;
+            r.privFlags = (*it)->privFlags;
+            strncpy(r.name, (*it)->name.string(), DISPLAY_MODE_NAME_MAX - 1);
+            r.name[DISPLAY_MODE_NAME_MAX - 1] = '\0';
+        }
+        return OK;
+    }
+
+    // Programs a per-channel gamma table where the hardware has one
+    virtual status_t setGammaLut(const GammaLut& /* lut */) {
+        return INVALID_OPERATION;
+    }
+
     virtual ~LiveDisplayBackend() {
     }
 };
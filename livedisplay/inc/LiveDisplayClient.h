@@ -0,0 +1,123 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAYCLIENT_H
+#define CYNGN_LIVEDISPLAYCLIENT_H
+
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+
+#include <LiveDisplayAPI.h>
+#include <LiveDisplayProtocol.h>
+
+namespace android {
+
+/*
+ * Requests queued to be sent to livedisplayd in a single round trip.
+ * Each add returns the index of the request, which is also the index of
+ * its response once the batch has been executed.
+ */
+class LiveDisplayBatch {
+  public:
+    size_t add(uint32_t op, int32_t value = 0);
+    size_t setDisplayMode(int32_t modeID, bool makeDefault);
+    size_t setPictureAdjustment(const HSIC& hsic);
+
+    size_t size() const {
+        return mRequests.size();
+    }
+
+    void clear();
+
+    const ld_response& response(size_t i) const {
+        return mResponses[i];
+    }
+    status_t status(size_t i) const {
+        return mResponses[i].status;
+    }
+
+    // Display modes listed by the response at index i
+    void getDisplayModes(size_t i, List<sp<DisplayMode>>& modes) const;
+
+  private:
+    friend class LiveDisplayClient;
+
+    std::vector<ld_request> mRequests;
+    std::vector<ld_response> mResponses;
+    std::vector<DisplayModeRecord> mRecords;
+};
+
+/*
+ * LiveDisplayAPI implemented by calls to livedisplayd. The connection
+ * is opened on first use and again after it breaks.
+ */
+class LiveDisplayClient : public LiveDisplayAPI {
+  public:
+    LiveDisplayClient();
+
+    // Uses an already connected socket, which is never reopened
+    explicit LiveDisplayClient(int fd);
+
+    virtual ~LiveDisplayClient();
+
+    // Sends every request in the batch and waits for all the responses
+    status_t execute(LiveDisplayBatch& batch);
+
+    // Hangs up, the next call connects again
+    void disconnect();
+
+    virtual uint32_t getSupportedFeatures();
+
+    virtual status_t setAdaptiveBacklightEnabled(bool enabled);
+    virtual bool isAdaptiveBacklightEnabled();
+
+    virtual status_t setOutdoorModeEnabled(bool enabled);
+    virtual bool isOutdoorModeEnabled();
+
+    virtual status_t getColorBalanceRange(Range& range);
+    virtual status_t setColorBalance(int32_t balance);
+    virtual int32_t getColorBalance();
+
+    virtual status_t getColorTemperatureRange(Range& range);
+    virtual status_t setColorTemperature(int32_t kelvin);
+    virtual int32_t getColorTemperature();
+
+    virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles);
+    virtual status_t setDisplayMode(int32_t modeID, bool makeDefault);
+    virtual sp<DisplayMode> getCurrentDisplayMode();
+    virtual sp<DisplayMode> getDefaultDisplayMode();
+
+    virtual status_t getPictureAdjustmentRanges(HSICRanges& ranges);
+    virtual status_t getPictureAdjustment(HSIC& hsic);
+    virtual status_t getDefaultPictureAdjustment(HSIC& hsic);
+    virtual status_t setPictureAdjustment(HSIC hsic);
+
+  private:
+    status_t call(uint32_t op, int32_t value, ld_response& resp);
+    status_t transact(LiveDisplayBatch& batch);
+    sp<DisplayMode> getMode(uint32_t op);
+    void closeSocket();
+
+    int mFd;
+    bool mOwned;
+    Mutex mLock;
+};
+};
+
+#endif
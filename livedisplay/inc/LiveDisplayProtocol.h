@@ -0,0 +1,144 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAYPROTOCOL_H
+#define CYNGN_LIVEDISPLAYPROTOCOL_H
+
+#include <stdint.h>
+
+#include <utils/Errors.h>
+
+#include <Types.h>
+
+/*
+ * Wire format spoken between livedisplayd and its clients over a stream
+ * socket. A frame is an ld_header followed by count fixed size entries,
+ * requests one way and responses the other. Each request gets exactly
+ * one response, in order, so several calls can share a round trip.
+ * Display modes listed by a response follow the entries as records.
+ */
+
+#define LIVEDISPLAY_SOCKET "livedisplay"
+
+#define LIVEDISPLAY_PROTOCOL_MAGIC 0x5043444c  // "LDCP"
+#define LIVEDISPLAY_PROTOCOL_VERSION 1
+
+#define LIVEDISPLAY_MAX_BATCH 32
+#define LIVEDISPLAY_MAX_RECORDS (LIVEDISPLAY_MAX_BATCH * MAX_DISPLAY_MODES)
+
+namespace android {
+
+enum LiveDisplayOp {
+    OP_GET_SUPPORTED_FEATURES = 1,
+    OP_SET_ADAPTIVE_BACKLIGHT,
+    OP_IS_ADAPTIVE_BACKLIGHT,
+    OP_SET_OUTDOOR_MODE,
+    OP_IS_OUTDOOR_MODE,
+    OP_GET_COLOR_BALANCE_RANGE,
+    OP_SET_COLOR_BALANCE,
+    OP_GET_COLOR_BALANCE,
+    OP_GET_COLOR_TEMPERATURE_RANGE,
+    OP_SET_COLOR_TEMPERATURE,
+    OP_GET_COLOR_TEMPERATURE,
+    OP_GET_DISPLAY_MODES,
+    OP_SET_DISPLAY_MODE,
+    OP_GET_CURRENT_DISPLAY_MODE,
+    OP_GET_DEFAULT_DISPLAY_MODE,
+    OP_GET_PICTURE_ADJUSTMENT_RANGES,
+    OP_GET_PICTURE_ADJUSTMENT,
+    OP_GET_DEFAULT_PICTURE_ADJUSTMENT,
+    OP_SET_PICTURE_ADJUSTMENT,
+    OP_INITIALIZE,  // brings the backend up if needed, value is its features
+};
+
+struct ld_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;    // entries in this frame
+    uint32_t records;  // display mode records after the entries
+};
+
+struct ld_hsic {
+    int32_t hue;
+    float saturation;
+    float intensity;
+    float contrast;
+    float saturationThreshold;
+};
+
+struct ld_range {
+    int32_t min;
+    int32_t max;
+    uint32_t step;
+};
+
+struct ld_float_range {
+    float min;
+    float max;
+    float step;
+};
+
+struct ld_request {
+    uint32_t op;
+    union {
+        int32_t value;  // flags, balance or kelvin
+        struct {
+            int32_t id;
+            int32_t makeDefault;
+        } mode;
+        ld_hsic hsic;
+    };
+};
+
+struct ld_response {
+    uint32_t op;
+    int32_t status;
+    union {
+        int32_t value;
+        ld_range range;
+        ld_hsic hsic;
+        struct {
+            ld_range hue;
+            ld_float_range saturation;
+            ld_float_range intensity;
+            ld_float_range contrast;
+            ld_float_range saturationThreshold;
+        } ranges;
+        struct {
+            uint32_t first;  // index of the first record
+            uint32_t count;
+        } modes;
+        DisplayModeRecord mode;
+    };
+};
+
+class LiveDisplayProtocol {
+  public:
+    static status_t writeFrame(int fd, const void* entries, uint32_t count, size_t size,
+                               const DisplayModeRecord* records = NULL, uint32_t nrecords = 0);
+
+    // Reads and validates a header, allowing at most max entries
+    static status_t readHeader(int fd, ld_header& header, uint32_t max);
+
+    static status_t readFully(int fd, void* data, size_t len);
+
+    static void toWire(const HSIC& hsic, ld_hsic& out);
+    static HSIC fromWire(const ld_hsic& hsic);
+};
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAYSERVER_H
+#define CYNGN_LIVEDISPLAYSERVER_H
+
+#include <vector>
+
+#include <utils/Errors.h>
+
+#include <LiveDisplayBackend.h>
+#include <LiveDisplayProtocol.h>
+
+// Clients served at once, system_server and the odd debugging tool
+#define LIVEDISPLAY_MAX_CLIENTS 8
+
+// A client stalling halfway through a frame is dropped after this long
+#define LIVEDISPLAY_CLIENT_TIMEOUT_MS 1000
+
+namespace android {
+
+/*
+ * Serves backend calls from other processes, so that a single process
+ * owns the backend connection. Clients are handled on one thread, a
+ * frame at a time, which keeps the backend calls serialized. Only
+ * system and root may connect.
+ */
+class LiveDisplayServer {
+  public:
+    explicit LiveDisplayServer(LiveDisplayBackend& backend)
+        : mBackend(backend), mInitialized(false), mFeatures(0) {
+    }
+
+    // Accepts and serves clients on a listening socket until it fails
+    status_t run(int listenFd);
+
+    // Handles requests from a connected client until it hangs up
+    status_t serve(int fd);
+
+  private:
+    status_t serveFrame(int fd);
+    void dispatch(const ld_request& req, ld_response& resp,
+                  std::vector<DisplayModeRecord>& records);
+    status_t initialize();
+
+    LiveDisplayBackend& mBackend;
+    bool mInitialized;
+    uint32_t mFeatures;
+
+    ld_request mRequests[LIVEDISPLAY_MAX_BATCH];
+    ld_response mResponses[LIVEDISPLAY_MAX_BATCH];
+    std::vector<DisplayModeRecord> mRecords;
+};
+};
+
+#endif
@@ -0,0 +1,50 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_PROFILESTORE_H
+#define CYNGN_LIVEDISPLAY_PROFILESTORE_H
+
+#include <utils/Errors.h>
+#include <utils/KeyedVector.h>
+
+#include <Types.h>
+
+namespace android {
+
+/*
+ * Display profiles registered by the framework, keyed by id. Only the
+ * target states are kept; the plan for a switch is built from the state
+ * the display is in at the time it is applied.
+ */
+class ProfileStore {
+  public:
+    void put(int32_t id, const DisplayState& state);
+    status_t remove(int32_t id);
+    void clear();
+
+    size_t size() const {
+        return mProfiles.size();
+    }
+
+    // Target state of profile id
+    status_t get(int32_t id, DisplayState& state) const;
+
+  private:
+    KeyedVector<int32_t, DisplayState> mProfiles;
+};
+};
+
+#endif
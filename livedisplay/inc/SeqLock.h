@@ -0,0 +1,90 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_SEQLOCK_H
+#define CYNGN_LIVEDISPLAY_SEQLOCK_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace android {
+
+/*
+ * Sequence lock for small values which are read far more often than
+ * they change. Readers never block and retry if a write raced with
+ * them. Writers must be serialized by the caller.
+ */
+template <typename T>
+class SeqLock {
+  public:
+    SeqLock() : mSeq(0) {
+    }
+
+    void write(const T& value) {
+        uint32_t seq = mSeq.load(std::memory_order_relaxed);
+        mSeq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mValue = value;
+        mSeq.store(seq + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        T value;
+        while (!tryRead(value, UINT32_MAX)) {
+        }
+        return value;
+    }
+
+    /*
+     * Gives up after the given number of attempts. Use this when the
+     * writer lives in another process and may die halfway through a
+     * write, which would leave the sequence odd forever.
+     */
+    bool tryRead(T& value, uint32_t attempts) const {
+        uint32_t before, after;
+        for (uint32_t i = 0; i < attempts; i++) {
+            before = mSeq.load(std::memory_order_acquire);
+            value = mValue;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = mSeq.load(std::memory_order_relaxed);
+            if ((before & 1) == 0 && before == after) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * Finishes a write abandoned by a writer that died, storing value in
+     * place of whatever was left half written. The caller must hold the
+     * writer lock.
+     */
+    void repair(const T& value) {
+        uint32_t seq = mSeq.load(std::memory_order_relaxed);
+        if ((seq & 1) != 0) {
+            mSeq.store(seq + 1, std::memory_order_release);
+            write(value);
+        }
+    }
+
+  private:
+    std::atomic<uint32_t> mSeq;
+    T mValue;
+};
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAY_SETTINGARBITER_H
+#define CYNGN_LIVEDISPLAY_SETTINGARBITER_H
+
+#include <utils/Errors.h>
+#include <utils/KeyedVector.h>
+
+#include <Types.h>
+
+namespace android {
+
+/*
+ * Resolves the settings requested by several clients, such as night
+ * mode, per-app profiles and outdoor mode, into the single state the
+ * display should be in. Each client holds one layer with the settings
+ * it cares about. Layers are stacked in priority order on top of the
+ * user's own settings, with the highest priority deciding each setting.
+ */
+class SettingArbiter {
+  public:
+    SettingArbiter() : mLayered(0) {
+    }
+
+    // Each returns true if the resolved state changed
+    bool setBase(const DisplayState& base);
+    bool set(int32_t client, int32_t priority, const DisplayState& state);
+    bool remove(int32_t client);
+
+    const DisplayState& resolved() const {
+        return mResolved;
+    }
+
+    size_t size() const {
+        return mLayers.size();
+    }
+
+    // Features in the layer of a client, zero if it has none
+    uint32_t features(int32_t client) const;
+
+    // Features decided by some layer rather than the base
+    uint32_t layered() const {
+        return mLayered;
+    }
+
+    // Counts the backend operations run on behalf of a client
+    void recordOps(int32_t client, uint32_t ops);
+
+    status_t getStats(int32_t client, ClientStats& stats) const;
+
+  private:
+    class Layer {
+      public:
+        Layer() : priority(0) {
+        }
+
+        int32_t priority;
+        DisplayState state;
+    };
+
+    bool resolve();
+
+    KeyedVector<int32_t, Layer> mLayers;
+    KeyedVector<int32_t, ClientStats> mStats;
+
+    DisplayState mBase;
+    DisplayState mResolved;
+    uint32_t mLayered;
+};
+};
+
+#endif
@@ -38,6 +38,12 @@ class Range {
     bool isNonZero() {
         return min != 0 || max != 0;
     }
+
+    // Scales value to [-1, 1] relative to the widest end of the range
+    float normalize(float value) const {
+        int32_t span = max > -min ? max : -min;
+        return span > 0 ? value / span : 0.0f;
+    }
 };
 
 class FloatRange {
@@ -56,6 +62,12 @@ class FloatRange {
     bool isNonZero() {
         return min != 0.0 || max != 0.0;
     }
+
+    // Scales value to [-1, 1] relative to the widest end of the range
+    float normalize(float value) const {
+        float span = max > -min ? max : -min;
+        return span > 0.0f ? value / span : 0.0f;
+    }
 };
 
 class HSIC {
@@ -81,6 +93,14 @@ class HSIC {
         saturationThreshold = o.saturationThreshold;
     }
 
+    bool operator==(const HSIC& o) const {
+        return hue == o.hue && saturation == o.saturation && intensity == o.intensity &&
+               contrast == o.contrast && saturationThreshold == o.saturationThreshold;
+    }
+    bool operator!=(const HSIC& o) const {
+        return !(*this == o);
+    }
+
     int32_t hue;
     float saturation;
     float intensity;
@@ -129,6 +149,19 @@ class DisplayMode : public RefBase {
     String8 privData;
 };
 
+#define DISPLAY_MODE_NAME_MAX 64
+#define MAX_DISPLAY_MODES 16
+
+/*
+ * Flat form of DisplayMode, so modes can be listed into a caller's
+ * buffer without any heap allocation.
+ */
+struct DisplayModeRecord {
+    int32_t id;
+    uint32_t privFlags;
+    char name[DISPLAY_MODE_NAME_MAX];
+};
+
 enum Level { OFF = -1, LOW, MEDIUM, HIGH, AUTO };
 
 enum Feature {
@@ -139,6 +172,136 @@ enum Feature {
     PICTURE_ADJUSTMENT = 0x10,
     MAX = PICTURE_ADJUSTMENT
 };
+
+/*
+ * Full set of user-visible LiveDisplay settings. Only the fields whose
+ * Feature bit is set in features are meaningful.
+ */
+class DisplayState {
+  public:
+    DisplayState()
+        : features(0), modeId(-1), colorBalance(0), outdoorMode(false), adaptiveBacklight(false) {
+    }
+
+    bool has(Feature f) const {
+        return (features & (uint32_t)f) != 0;
+    }
+
+    // Equal if the same settings are flagged and hold the same values
+    bool operator==(const DisplayState& o) const {
+        return features == o.features &&
+               (!has(Feature::DISPLAY_MODES) || modeId == o.modeId) &&
+               (!has(Feature::COLOR_TEMPERATURE) || colorBalance == o.colorBalance) &&
+               (!has(Feature::PICTURE_ADJUSTMENT) || pictureAdjustment == o.pictureAdjustment) &&
+               (!has(Feature::OUTDOOR_MODE) || outdoorMode == o.outdoorMode) &&
+               (!has(Feature::ADAPTIVE_BACKLIGHT) || adaptiveBacklight == o.adaptiveBacklight);
+    }
+    bool operator!=(const DisplayState& o) const {
+        return !(*this == o);
+    }
+
+    /*
+     * Takes the settings flagged in o, as if they were applied after
+     * this state. A new display mode drops the picture adjustment.
+     */
+    void merge(const DisplayState& o) {
+        if (o.has(Feature::DISPLAY_MODES)) {
+            modeId = o.modeId;
+            features &= ~Feature::PICTURE_ADJUSTMENT;
+        }
+        if (o.has(Feature::COLOR_TEMPERATURE)) {
+            colorBalance = o.colorBalance;
+        }
+        if (o.has(Feature::PICTURE_ADJUSTMENT)) {
+            pictureAdjustment = o.pictureAdjustment;
+        }
+        if (o.has(Feature::OUTDOOR_MODE)) {
+            outdoorMode = o.outdoorMode;
+        }
+        if (o.has(Feature::ADAPTIVE_BACKLIGHT)) {
+            adaptiveBacklight = o.adaptiveBacklight;
+        }
+        features |= o.features;
+    }
+
+    uint32_t features;
+    int32_t modeId;
+    int32_t colorBalance;
+    HSIC pictureAdjustment;
+    bool outdoorMode;
+    bool adaptiveBacklight;
+};
+
+class LiveDisplayStats {
+  public:
+    LiveDisplayStats()
+        : plans(0),
+          lastPlanSize(0),
+          planOps(0),
+          skippedOps(0),
+          profileSwitches(0),
+          lastProfileLatencyUs(0),
+          maxProfileLatencyUs(0),
+          deferredSettings(0),
+          deferredCommits(0),
+          retries(0),
+          reconnects(0),
+          resets(0),
+          backoffSkips(0),
+          lastProbeUs(0) {
+    }
+
+    uint32_t plans;         // state changes applied through the planner
+    uint32_t lastPlanSize;  // backend operations in the last plan
+    uint32_t planOps;       // backend operations issued by all plans
+    uint32_t skippedOps;    // requested settings which were already applied
+
+    uint32_t profileSwitches;
+    uint32_t lastProfileLatencyUs;
+    uint32_t maxProfileLatencyUs;
+
+    uint32_t deferredSettings;  // changes held back while the panel was off
+    uint32_t deferredCommits;   // plans run at unblank to apply them
+
+    uint32_t retries;       // backend calls repeated after a transient failure
+    uint32_t reconnects;    // light reconnects, keeping the probed features
+    uint32_t resets;        // full resets after recovery failed
+    uint32_t backoffSkips;  // connects refused while backing off
+
+    uint32_t lastProbeUs;  // time taken to probe features on the last connect
+};
+
+class BackendHealth {
+  public:
+    BackendHealth()
+        : degraded(false),
+          hungCalls(0),
+          rejectedCalls(0),
+          recoveries(0),
+          currentHangMs(0),
+          lastHangMs(0),
+          maxHangMs(0) {
+    }
+
+    bool degraded;           // a backend call is stuck past its deadline
+    uint32_t hungCalls;      // calls which missed their deadline
+    uint32_t rejectedCalls;  // calls refused while another was stuck
+    uint32_t recoveries;     // stuck calls which eventually returned
+    uint32_t currentHangMs;  // how long the stuck call has been running
+    uint32_t lastHangMs;     // duration of the last stuck call to return
+    uint32_t maxHangMs;
+};
+
+class ClientStats {
+  public:
+    ClientStats() : requests(0), changes(0), ops(0), owned(0) {
+    }
+
+    uint32_t requests;  // layer updates from the client
+    uint32_t changes;   // updates which changed the resolved state
+    uint32_t ops;       // backend operations run for those changes
+    uint32_t owned;     // features the client's layer currently decides
+};
 };
 
 #endif
@@ -16,10 +16,17 @@
 
 #define LOG_TAG "LiveDisplay-HW"
 
+#include <string.h>
+
+#include <vector>
+
+#include <utils/Mutex.h>
+
 #include "jniutils.h"
 
 #include "Types.h"
 #include "LiveDisplay.h"
+#include "StatePage.h"
 
 namespace android {
 
@@ -32,7 +39,6 @@ static struct {
 
 static struct {
     jclass clazz;
-    jmethodID constructor;
     jfieldID mHue;
     jfieldID mSaturation;
     jfieldID mIntensity;
@@ -40,21 +46,51 @@ static struct {
     jfieldID mSaturationThreshold;
 } gHSICClass;
 
+/*
+ * DisplayMode[] handed to Java, kept as a global reference along with
+ * the ids in the same order. Rebuilt when the native mode list may have
+ * changed. Callers must not modify the array.
+ */
 static struct {
-    jclass clazz;
-    jmethodID constructor;
-} gRangeClass;
-
-static struct {
-    jclass clazz;
-    jmethodID constructor;
-} gFloatClass;
+    Mutex lock;
+    uint32_t generation;
+    jobjectArray modes;
+    std::vector<int32_t> ids;
+} gDisplayModeCache;
+
+// Layout of the arrays filled by native_getRanges, mirrored in LiveDisplayVendorImpl
+enum {
+    INT_RANGE_COLOR_BALANCE = 0,
+    INT_RANGE_COLOR_TEMPERATURE = 3,
+    INT_RANGE_HUE = 6,
+    INT_RANGES_SIZE = 9,
+};
 
-static struct {
-    jclass clazz;
-    jmethodID constructor;
-} gIntegerClass;
+enum {
+    FLOAT_RANGE_SATURATION = 0,
+    FLOAT_RANGE_INTENSITY = 3,
+    FLOAT_RANGE_CONTRAST = 6,
+    FLOAT_RANGE_SATURATION_THRESHOLD = 9,
+    FLOAT_RANGES_SIZE = 12,
+};
 
+#define HSIC_SIZE 5
+
+// Layout of the array returned by native_getState, floats are stored as raw bits
+enum {
+    STATE_FEATURES = 0,
+    STATE_MODE_ID,
+    STATE_COLOR_BALANCE,
+    STATE_COLOR_TEMPERATURE,
+    STATE_HUE,
+    STATE_SATURATION,
+    STATE_INTENSITY,
+    STATE_CONTRAST,
+    STATE_SATURATION_THRESHOLD,
+    STATE_OUTDOOR_MODE,
+    STATE_ADAPTIVE_BACKLIGHT,
+    STATE_SIZE,
+};
 
 static jobject displayModeToObject(JNIEnv* env, sp<DisplayMode> mode)
 {
@@ -67,56 +103,71 @@ static jobject displayModeToObject(JNIEnv* env, sp<DisplayMode> mode)
             env->NewStringUTF(mode->name.string()));
 }
 
-static sp<DisplayMode> objectToDisplayMode(JNIEnv* env, jobject mode)
+static HSIC objectToHSIC(JNIEnv* env, jobject hsic)
 {
-    jstring name = (jstring) env->GetObjectField(mode, gDisplayModeClass.name);
-    return new DisplayMode((int32_t) env->GetIntField(mode, gDisplayModeClass.id),
-            env->GetStringUTFChars(name, NULL),
-            env->GetStringUTFLength(name));
+    return HSIC(static_cast<int32_t>(env->GetFloatField(hsic, gHSICClass.mHue)),
+            env->GetFloatField(hsic, gHSICClass.mSaturation),
+            env->GetFloatField(hsic, gHSICClass.mIntensity),
+            env->GetFloatField(hsic, gHSICClass.mContrast),
+            env->GetFloatField(hsic, gHSICClass.mSaturationThreshold));
 }
 
-static jobject floatRangeToObject(JNIEnv* env, FloatRange range)
+/*
+ * These are served from the native shadow once the value is known, but the
+ * first call can still go to the backend, so they stay regular JNI calls.
+ */
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_isAdaptiveBacklightEnabled(
+        JNIEnv* env __unused, jclass thiz __unused)
 {
-    jobject lower = env->NewObject(gFloatClass.clazz, gFloatClass.constructor,
-            (jfloat) range.min);
+    return LiveDisplay::getInstance().isAdaptiveBacklightEnabled();
+}
 
-    jobject upper = env->NewObject(gFloatClass.clazz, gFloatClass.constructor,
-            (jfloat) range.max);
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_isOutdoorModeEnabled(
+        JNIEnv* env __unused, jclass thiz __unused)
+{
+    return LiveDisplay::getInstance().isOutdoorModeEnabled();
+}
 
-    return env->NewObject(gRangeClass.clazz, gRangeClass.constructor,
-            lower, upper);
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorBalance(
+        JNIEnv* env __unused, jclass thiz __unused)
+{
+    return LiveDisplay::getInstance().getColorBalance();
 }
 
-static jobject intRangeToObject(JNIEnv* env, Range range)
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_getSupportedFeatures(
+        JNIEnv* env __unused, jclass thiz __unused)
 {
-    jobject lower = env->NewObject(gIntegerClass.clazz, gIntegerClass.constructor,
-            (jint) range.min);
+    return (jint) LiveDisplay::getInstance().getSupportedFeatures();
+}
 
-    jobject upper = env->NewObject(gIntegerClass.clazz, gIntegerClass.constructor,
-            (jint) range.max);
+/*
+ * Take neither env nor class, which suits @CriticalNative: they only read
+ * the shadow and never block, and return PEEK_UNKNOWN until a value is
+ * known. Registered as regular natives until the platform has the former.
+ */
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekSupportedFeatures()
+{
+    return LiveDisplay::getInstance().peekSupportedFeatures();
+}
 
-    return env->NewObject(gRangeClass.clazz, gRangeClass.constructor,
-            lower, upper);
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekColorBalance()
+{
+    return LiveDisplay::getInstance().peekColorBalance();
 }
 
-static jobject hsicToObject(JNIEnv* env, HSIC hsic)
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekColorTemperature()
 {
-    return env->NewObject(gHSICClass.clazz, gHSICClass.constructor,
-            (jfloat) hsic.hue, (jfloat) hsic.saturation,
-            (jfloat) hsic.intensity, (jfloat) hsic.contrast,
-            (jfloat) hsic.saturationThreshold);
+    return LiveDisplay::getInstance().peekColorTemperature();
 }
 
-static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_getSupportedFeatures(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekOutdoorMode()
 {
-    return (jint) LiveDisplay::getInstance().getSupportedFeatures();
+    return LiveDisplay::getInstance().peekOutdoorMode();
 }
 
-static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_isAdaptiveBacklightEnabled(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekAdaptiveBacklight()
 {
-    return LiveDisplay::getInstance().isAdaptiveBacklightEnabled();
+    return LiveDisplay::getInstance().peekAdaptiveBacklight();
 }
 
 static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setAdaptiveBacklightEnabled(
@@ -125,56 +176,102 @@ static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setAdaptiveBackli
     return LiveDisplay::getInstance().setAdaptiveBacklightEnabled(enabled) == OK;
 }
 
-static jobjectArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDisplayModes(
-        JNIEnv* env, jclass thiz __unused)
+// Called with gDisplayModeCache.lock held
+static jobjectArray getCachedDisplayModes(JNIEnv* env)
 {
-    List<sp<DisplayMode>> modes;
-    status_t rc = LiveDisplay::getInstance().getDisplayModes(modes);
-    if (rc != OK) {
+    uint32_t generation = LiveDisplay::getInstance().getDisplayModesGeneration();
+    if (gDisplayModeCache.modes != NULL && gDisplayModeCache.generation == generation) {
+        return gDisplayModeCache.modes;
+    }
+
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+    if (LiveDisplay::getInstance().getDisplayModeRecords(records, MAX_DISPLAY_MODES,
+            count) != OK) {
+        return NULL;
+    }
+
+    jobjectArray modeList = env->NewObjectArray(count, gDisplayModeClass.clazz, NULL);
+    if (modeList == NULL) {
         return NULL;
     }
 
-    jobjectArray modeList = env->NewObjectArray(modes.size(), gDisplayModeClass.clazz, NULL);
-    int i = 0;
+    std::vector<int32_t> ids;
+    for (size_t i = 0; i < count; i++) {
+        jstring name = env->NewStringUTF(records[i].name);
+        jobject obj = env->NewObject(gDisplayModeClass.clazz, gDisplayModeClass.constructor,
+                (jint) records[i].id, name);
+        env->SetObjectArrayElement(modeList, i, obj);
+        env->DeleteLocalRef(obj);
+        env->DeleteLocalRef(name);
+        ids.push_back(records[i].id);
+    }
+
+    if (gDisplayModeCache.modes != NULL) {
+        env->DeleteGlobalRef(gDisplayModeCache.modes);
+    }
+    gDisplayModeCache.modes = (jobjectArray) env->NewGlobalRef(modeList);
+    gDisplayModeCache.ids.swap(ids);
+    gDisplayModeCache.generation = generation;
+    env->DeleteLocalRef(modeList);
+    return gDisplayModeCache.modes;
+}
 
-    if (rc == OK) {
-        for (List<sp<DisplayMode>>::iterator it = modes.begin();
-                it != modes.end(); ++it) {
-            const sp<DisplayMode> mode = *it;
-            env->SetObjectArrayElement(modeList, i,
-                    displayModeToObject(env, mode));
-            i++;
+// Looks the mode up in the cache so the name isn't converted again
+static jobject cachedDisplayModeToObject(JNIEnv* env, sp<DisplayMode> mode)
+{
+    if (!mode.get() || mode->id < 0) {
+        return NULL;
+    }
+
+    Mutex::Autolock _l(gDisplayModeCache.lock);
+    jobjectArray modes = getCachedDisplayModes(env);
+    if (modes != NULL) {
+        for (size_t i = 0; i < gDisplayModeCache.ids.size(); i++) {
+            if (gDisplayModeCache.ids[i] == mode->id) {
+                return env->GetObjectArrayElement(modes, i);
+            }
         }
     }
+    return displayModeToObject(env, mode);
+}
 
-    return modeList;
+static jobjectArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDisplayModes(
+        JNIEnv* env, jclass thiz __unused)
+{
+    Mutex::Autolock _l(gDisplayModeCache.lock);
+    jobjectArray modes = getCachedDisplayModes(env);
+    return modes != NULL ? (jobjectArray) env->NewLocalRef(modes) : NULL;
 }
 
 static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getCurrentDisplayMode(
         JNIEnv* env, jclass thiz __unused)
 {
-    return displayModeToObject(env,
+    return cachedDisplayModeToObject(env,
             LiveDisplay::getInstance().getCurrentDisplayMode());
 }
 
 static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDefaultDisplayMode(
         JNIEnv* env, jclass thiz __unused)
 {
-    return displayModeToObject(env,
+    return cachedDisplayModeToObject(env,
             LiveDisplay::getInstance().getDefaultDisplayMode());
 }
 
 static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setDisplayMode(
         JNIEnv* env, jclass thiz __unused, jobject mode, jboolean makeDefault)
 {
+    if (mode == NULL) {
+        return false;
+    }
     return LiveDisplay::getInstance().setDisplayMode(
-            objectToDisplayMode(env, mode)->id, makeDefault) == OK;
+            env->GetIntField(mode, gDisplayModeClass.id), makeDefault) == OK;
 }
 
-static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_isOutdoorModeEnabled(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setDisplayModeById(
+        JNIEnv* env __unused, jclass thiz __unused, jint id, jboolean makeDefault)
 {
-    return LiveDisplay::getInstance().isOutdoorModeEnabled();
+    return LiveDisplay::getInstance().setDisplayMode(id, makeDefault) == OK;
 }
 
 static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setOutdoorModeEnabled(
@@ -183,133 +280,343 @@ static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setOutdoorModeEna
     return LiveDisplay::getInstance().setOutdoorModeEnabled(enabled) == OK;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorBalanceRange(
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setColorBalance(
+        JNIEnv* env __unused, jclass thiz __unused, jint value)
+{
+    return LiveDisplay::getInstance().setColorBalance(value) == OK;
+}
+
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorTemperature(
         JNIEnv* env __unused, jclass thiz __unused)
 {
+    return LiveDisplay::getInstance().getColorTemperature();
+}
+
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setColorTemperature(
+        JNIEnv* env __unused, jclass thiz __unused, jint kelvin)
+{
+    return LiveDisplay::getInstance().setColorTemperature(kelvin) == OK;
+}
+
+static void putRange(jint* out, const Range& range)
+{
+    out[0] = range.min;
+    out[1] = range.max;
+    out[2] = range.step;
+}
+
+static void putRange(jfloat* out, const FloatRange& range)
+{
+    out[0] = range.min;
+    out[1] = range.max;
+    out[2] = range.step;
+}
+
+static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_getRanges(
+        JNIEnv* env, jclass thiz __unused, jintArray intRanges, jfloatArray floatRanges)
+{
+    if (intRanges == NULL || floatRanges == NULL ||
+            env->GetArrayLength(intRanges) < INT_RANGES_SIZE ||
+            env->GetArrayLength(floatRanges) < FLOAT_RANGES_SIZE) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "range arrays too small");
+        return 0;
+    }
+
+    LiveDisplay& ld = LiveDisplay::getInstance();
+    jint ints[INT_RANGES_SIZE] = { 0 };
+    jfloat floats[FLOAT_RANGES_SIZE] = { 0 };
+    jint valid = 0;
+
     Range range;
-    if (LiveDisplay::getInstance().getColorBalanceRange(range) == OK) {
-        return intRangeToObject(env, range);
+    if (ld.getColorBalanceRange(range) == OK) {
+        putRange(&ints[INT_RANGE_COLOR_BALANCE], range);
+        valid |= Feature::COLOR_TEMPERATURE;
+        if (ld.getColorTemperatureRange(range) == OK) {
+            putRange(&ints[INT_RANGE_COLOR_TEMPERATURE], range);
+        }
+    }
+
+    HSICRanges ranges;
+    if (ld.getPictureAdjustmentRanges(ranges) == OK) {
+        putRange(&ints[INT_RANGE_HUE], ranges.hue);
+        putRange(&floats[FLOAT_RANGE_SATURATION], ranges.saturation);
+        putRange(&floats[FLOAT_RANGE_INTENSITY], ranges.intensity);
+        putRange(&floats[FLOAT_RANGE_CONTRAST], ranges.contrast);
+        putRange(&floats[FLOAT_RANGE_SATURATION_THRESHOLD], ranges.saturationThreshold);
+        valid |= Feature::PICTURE_ADJUSTMENT;
     }
-    return NULL;
+
+    env->SetIntArrayRegion(intRanges, 0, INT_RANGES_SIZE, ints);
+    env->SetFloatArrayRegion(floatRanges, 0, FLOAT_RANGES_SIZE, floats);
+    return valid;
 }
 
-static jint org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorBalance(
-        JNIEnv* env __unused, jclass thiz __unused)
+static void putHSIC(JNIEnv* env, jfloatArray array, const HSIC& hsic)
 {
-    return LiveDisplay::getInstance().getColorBalance();
+    jfloat values[HSIC_SIZE] = {
+        (jfloat) hsic.hue, hsic.saturation, hsic.intensity, hsic.contrast,
+        hsic.saturationThreshold
+    };
+    env->SetFloatArrayRegion(array, 0, HSIC_SIZE, values);
 }
 
-static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setColorBalance(
-        JNIEnv* env __unused, jclass thiz __unused, jint value)
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPictureAdjustmentValues(
+        JNIEnv* env, jclass thiz __unused, jfloatArray out)
 {
-    return LiveDisplay::getInstance().setColorBalance(value) == OK;
+    HSIC hsic;
+    if (out == NULL || env->GetArrayLength(out) < HSIC_SIZE ||
+            LiveDisplay::getInstance().getPictureAdjustment(hsic) != OK) {
+        return false;
+    }
+    putHSIC(env, out, hsic);
+    return true;
 }
 
-static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setPictureAdjustment(
-        JNIEnv* env __unused, jclass thiz __unused, jobject hsicObj)
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDefaultPictureAdjustmentValues(
+        JNIEnv* env, jclass thiz __unused, jfloatArray out)
 {
-    HSIC hsic(static_cast<int32_t>(env->GetFloatField(hsicObj, gHSICClass.mHue)),
-            env->GetFloatField(hsicObj, gHSICClass.mSaturation),
-            env->GetFloatField(hsicObj, gHSICClass.mIntensity),
-            env->GetFloatField(hsicObj, gHSICClass.mContrast),
-            env->GetFloatField(hsicObj, gHSICClass.mSaturationThreshold));
+    HSIC hsic;
+    if (out == NULL || env->GetArrayLength(out) < HSIC_SIZE ||
+            LiveDisplay::getInstance().getDefaultPictureAdjustment(hsic) != OK) {
+        return false;
+    }
+    putHSIC(env, out, hsic);
+    return true;
+}
 
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setPictureAdjustmentValues(
+        JNIEnv* env, jclass thiz __unused, jfloatArray in)
+{
+    if (in == NULL || env->GetArrayLength(in) < HSIC_SIZE) {
+        return false;
+    }
+
+    jfloat values[HSIC_SIZE];
+    env->GetFloatArrayRegion(in, 0, HSIC_SIZE, values);
+    HSIC hsic(static_cast<int32_t>(values[0]), values[1], values[2], values[3], values[4]);
     return LiveDisplay::getInstance().setPictureAdjustment(hsic) == OK;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPictureAdjustment(
-        JNIEnv* env __unused, jclass thiz __unused)
+static bool toDisplayState(JNIEnv* env, jint features, jobject mode, jint colorBalance,
+        jobject hsicObj, jboolean outdoorMode, jboolean adaptiveBacklight, DisplayState& state)
 {
-    HSIC hsic;
+    state.features = features;
+    if (state.has(Feature::DISPLAY_MODES)) {
+        if (mode == NULL) {
+            return false;
+        }
+        state.modeId = env->GetIntField(mode, gDisplayModeClass.id);
+    }
+    if (state.has(Feature::PICTURE_ADJUSTMENT)) {
+        if (hsicObj == NULL) {
+            return false;
+        }
+        state.pictureAdjustment = objectToHSIC(env, hsicObj);
+    }
+    state.colorBalance = colorBalance;
+    state.outdoorMode = outdoorMode;
+    state.adaptiveBacklight = adaptiveBacklight;
+    return true;
+}
 
-    ALOGD("getPictureAdjustment");
-    if (LiveDisplay::getInstance().getPictureAdjustment(hsic) != OK) {
-        return NULL;
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_applyState(
+        JNIEnv* env, jclass thiz __unused, jint features, jobject mode, jint colorBalance,
+        jobject hsicObj, jboolean outdoorMode, jboolean adaptiveBacklight)
+{
+    DisplayState state;
+    if (!toDisplayState(env, features, mode, colorBalance, hsicObj, outdoorMode,
+            adaptiveBacklight, state)) {
+        return false;
     }
+    return LiveDisplay::getInstance().applyState(state) == OK;
+}
 
-    return hsicToObject(env, hsic);
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setProfile(
+        JNIEnv* env, jclass thiz __unused, jint id, jint features, jobject mode,
+        jint colorBalance, jobject hsicObj, jboolean outdoorMode, jboolean adaptiveBacklight)
+{
+    DisplayState state;
+    if (!toDisplayState(env, features, mode, colorBalance, hsicObj, outdoorMode,
+            adaptiveBacklight, state)) {
+        return false;
+    }
+    return LiveDisplay::getInstance().setProfile(id, state) == OK;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDefaultPictureAdjustment(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_removeProfile(
+        JNIEnv* env __unused, jclass thiz __unused, jint id)
 {
-    HSIC hsic;
+    return LiveDisplay::getInstance().removeProfile(id) == OK;
+}
 
-    ALOGD("getDefaultPictureAdjustment");
-    if (LiveDisplay::getInstance().getDefaultPictureAdjustment(hsic) != OK) {
-        return NULL;
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_applyProfile(
+        JNIEnv* env __unused, jclass thiz __unused, jint id)
+{
+    return LiveDisplay::getInstance().applyProfile(id) == OK;
+}
+
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setClientLayer(
+        JNIEnv* env, jclass thiz __unused, jint client, jint priority, jint features,
+        jobject mode, jint colorBalance, jobject hsicObj, jboolean outdoorMode,
+        jboolean adaptiveBacklight)
+{
+    DisplayState state;
+    if (!toDisplayState(env, features, mode, colorBalance, hsicObj, outdoorMode,
+            adaptiveBacklight, state)) {
+        return false;
     }
+    return LiveDisplay::getInstance().setClientLayer(client, priority, state) == OK;
+}
 
-    return hsicToObject(env, hsic);
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_removeClientLayer(
+        JNIEnv* env __unused, jclass thiz __unused, jint client)
+{
+    return LiveDisplay::getInstance().removeClientLayer(client) == OK;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPictureAdjustmentRanges(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jintArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getClientStats(
+        JNIEnv* env, jclass thiz __unused, jint client)
 {
-    HSICRanges ranges;
-    if (LiveDisplay::getInstance().getPictureAdjustmentRanges(ranges) == OK) {
-        jobjectArray modeList = env->NewObjectArray(5, gRangeClass.clazz, NULL);
-        env->SetObjectArrayElement(modeList, 0, intRangeToObject(env, ranges.hue));
-        env->SetObjectArrayElement(modeList, 1, floatRangeToObject(env, ranges.saturation));
-        env->SetObjectArrayElement(modeList, 2, floatRangeToObject(env, ranges.intensity));
-        env->SetObjectArrayElement(modeList, 3, floatRangeToObject(env, ranges.contrast));
-        env->SetObjectArrayElement(modeList, 4, floatRangeToObject(env, ranges.saturationThreshold));
-        return modeList;
+    ClientStats stats;
+    if (LiveDisplay::getInstance().getClientStats(client, stats) != OK) {
+        return NULL;
     }
-    return NULL;
 
+    jint values[] = {
+        (jint) stats.requests,
+        (jint) stats.changes,
+        (jint) stats.ops,
+        (jint) stats.owned,
+    };
+
+    jintArray array = env->NewIntArray(NELEM(values));
+    if (array != NULL) {
+        env->SetIntArrayRegion(array, 0, NELEM(values), values);
+    }
+    return array;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getHueRange(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jint floatBits(float value)
 {
-    HSICRanges ranges;
-    if (LiveDisplay::getInstance().getPictureAdjustmentRanges(ranges) == OK) {
-        return floatRangeToObject(env, FloatRange(ranges.hue.min, ranges.hue.max));
-    }
-    return NULL;
+    jint bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getSaturationRange(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jintArray stateToArray(JNIEnv* env, const DisplayState& state, int32_t kelvin)
 {
-    HSICRanges ranges;
-    if (LiveDisplay::getInstance().getPictureAdjustmentRanges(ranges) == OK) {
-        return floatRangeToObject(env, ranges.saturation);
+    jint values[STATE_SIZE];
+    values[STATE_FEATURES] = state.features;
+    values[STATE_MODE_ID] = state.modeId;
+    values[STATE_COLOR_BALANCE] = state.colorBalance;
+    values[STATE_COLOR_TEMPERATURE] = kelvin;
+    values[STATE_HUE] = state.pictureAdjustment.hue;
+    values[STATE_SATURATION] = floatBits(state.pictureAdjustment.saturation);
+    values[STATE_INTENSITY] = floatBits(state.pictureAdjustment.intensity);
+    values[STATE_CONTRAST] = floatBits(state.pictureAdjustment.contrast);
+    values[STATE_SATURATION_THRESHOLD] = floatBits(state.pictureAdjustment.saturationThreshold);
+    values[STATE_OUTDOOR_MODE] = state.outdoorMode;
+    values[STATE_ADAPTIVE_BACKLIGHT] = state.adaptiveBacklight;
+
+    jintArray array = env->NewIntArray(STATE_SIZE);
+    if (array != NULL) {
+        env->SetIntArrayRegion(array, 0, STATE_SIZE, values);
     }
-    return NULL;
+    return array;
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getIntensityRange(
-        JNIEnv* env __unused, jclass thiz __unused)
+static jintArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getState(
+        JNIEnv* env, jclass thiz __unused)
 {
-    HSICRanges ranges;
-    if (LiveDisplay::getInstance().getPictureAdjustmentRanges(ranges) == OK) {
-        return floatRangeToObject(env, ranges.intensity);
+    DisplayState state;
+    int32_t kelvin = -1;
+    if (LiveDisplay::getInstance().getState(state, kelvin) != OK) {
+        return NULL;
     }
-    return NULL;
+    return stateToArray(env, state, kelvin);
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getContrastRange(
-        JNIEnv* env __unused, jclass thiz __unused)
+/*
+ * Reads the state last published by whichever process drives the
+ * display, without loading the backend or taking the LiveDisplay lock.
+ */
+static jintArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPublishedState(
+        JNIEnv* env, jclass thiz __unused)
 {
-    HSICRanges ranges;
-    if (LiveDisplay::getInstance().getPictureAdjustmentRanges(ranges) == OK) {
-        return floatRangeToObject(env, ranges.contrast);
+    static Mutex sLock;
+    static StatePage sPage;
+    {
+        Mutex::Autolock _l(sLock);
+        if (sPage.openForRead() != OK) {
+            return NULL;
+        }
     }
-    return NULL;
+
+    DisplayState state;
+    if (sPage.read(state) != OK) {
+        return NULL;
+    }
+    return stateToArray(env, state, -1);
 }
 
-static jobject org_cyanogenmod_hardware_LiveDisplayVendorImpl_getSaturationThresholdRange (
-        JNIEnv* env __unused, jclass thiz __unused)
+static jboolean org_cyanogenmod_hardware_LiveDisplayVendorImpl_setScreenOn(
+        JNIEnv* env __unused, jclass thiz __unused, jboolean on)
 {
-    HSICRanges ranges;
-    if (LiveDisplay::getInstance().getPictureAdjustmentRanges(ranges) == OK) {
-        return floatRangeToObject(env, ranges.saturationThreshold);
+    return LiveDisplay::getInstance().setScreenOn(on) == OK;
+}
+
+static jintArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getStats(
+        JNIEnv* env, jclass thiz __unused)
+{
+    LiveDisplayStats stats;
+    LiveDisplay::getInstance().getStats(stats);
+
+    jint values[] = {
+        (jint) stats.plans,
+        (jint) stats.lastPlanSize,
+        (jint) stats.planOps,
+        (jint) stats.skippedOps,
+        (jint) stats.profileSwitches,
+        (jint) stats.lastProfileLatencyUs,
+        (jint) stats.maxProfileLatencyUs,
+        (jint) stats.deferredSettings,
+        (jint) stats.deferredCommits,
+        (jint) stats.retries,
+        (jint) stats.reconnects,
+        (jint) stats.resets,
+        (jint) stats.backoffSkips,
+        (jint) stats.lastProbeUs,
+    };
+
+    jintArray array = env->NewIntArray(NELEM(values));
+    if (array != NULL) {
+        env->SetIntArrayRegion(array, 0, NELEM(values), values);
     }
-    return NULL;
+    return array;
 }
 
+static jintArray org_cyanogenmod_hardware_LiveDisplayVendorImpl_getHealth(
+        JNIEnv* env, jclass thiz __unused)
+{
+    BackendHealth health;
+    LiveDisplay::getInstance().getHealth(health);
+
+    jint values[] = {
+        (jint) health.degraded,
+        (jint) health.hungCalls,
+        (jint) health.rejectedCalls,
+        (jint) health.recoveries,
+        (jint) health.currentHangMs,
+        (jint) health.lastHangMs,
+        (jint) health.maxHangMs,
+    };
+
+    jintArray array = env->NewIntArray(NELEM(values));
+    if (array != NULL) {
+        env->SetIntArrayRegion(array, 0, NELEM(values), values);
+    }
+    return array;
+}
 
 static JNINativeMethod gLiveDisplayVendorImplMethods[] = {
     { "native_getSupportedFeatures",
@@ -333,48 +640,92 @@ static JNINativeMethod gLiveDisplayVendorImplMethods[] = {
     { "native_setDisplayMode",
         "(Lcyanogenmod/hardware/DisplayMode;Z)Z",
         (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setDisplayMode },
+    { "native_setDisplayModeById",
+        "(IZ)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setDisplayModeById },
     { "native_isOutdoorModeEnabled",
         "()Z",
         (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_isOutdoorModeEnabled },
     { "native_setOutdoorModeEnabled",
         "(Z)Z",
         (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setOutdoorModeEnabled },
-    { "native_getColorBalanceRange",
-        "()Landroid/util/Range;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorBalanceRange },
     { "native_getColorBalance",
         "()I",
         (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorBalance },
     { "native_setColorBalance",
         "(I)Z",
         (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setColorBalance },
-    { "native_setPictureAdjustment",
-        "(Lcyanogenmod/hardware/HSIC;)Z",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setPictureAdjustment },
-    { "native_getPictureAdjustment",
-        "()Lcyanogenmod/hardware/HSIC;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPictureAdjustment },
-    { "native_getDefaultPictureAdjustment",
-        "()Lcyanogenmod/hardware/HSIC;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDefaultPictureAdjustment },
-    { "native_getHueRange",
-        "()Landroid/util/Range;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getHueRange },
-    { "native_getSaturationRange",
-        "()Landroid/util/Range;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getSaturationRange },
-    { "native_getIntensityRange",
-        "()Landroid/util/Range;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getIntensityRange },
-    { "native_getContrastRange",
-        "()Landroid/util/Range;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getContrastRange },
-    { "native_getSaturationThresholdRange",
-        "()Landroid/util/Range;",
-        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getSaturationThresholdRange },
+    { "native_getColorTemperature",
+        "()I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getColorTemperature },
+    { "native_setColorTemperature",
+        "(I)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setColorTemperature },
+    { "native_peekSupportedFeatures",
+        "()I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekSupportedFeatures },
+    { "native_peekColorBalance",
+        "()I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekColorBalance },
+    { "native_peekColorTemperature",
+        "()I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekColorTemperature },
+    { "native_peekOutdoorMode",
+        "()I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekOutdoorMode },
+    { "native_peekAdaptiveBacklight",
+        "()I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_peekAdaptiveBacklight },
+    { "native_applyState",
+        "(ILcyanogenmod/hardware/DisplayMode;ILcyanogenmod/hardware/HSIC;ZZ)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_applyState },
+    { "native_setProfile",
+        "(IILcyanogenmod/hardware/DisplayMode;ILcyanogenmod/hardware/HSIC;ZZ)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setProfile },
+    { "native_removeProfile",
+        "(I)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_removeProfile },
+    { "native_applyProfile",
+        "(I)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_applyProfile },
+    { "native_getState",
+        "()[I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getState },
+    { "native_getPublishedState",
+        "()[I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPublishedState },
+    { "native_setScreenOn",
+        "(Z)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setScreenOn },
+    { "native_setClientLayer",
+        "(IIILcyanogenmod/hardware/DisplayMode;ILcyanogenmod/hardware/HSIC;ZZ)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setClientLayer },
+    { "native_removeClientLayer",
+        "(I)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_removeClientLayer },
+    { "native_getClientStats",
+        "(I)[I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getClientStats },
+    { "native_getStats",
+        "()[I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getStats },
+    { "native_getHealth",
+        "()[I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getHealth },
+    { "native_getRanges",
+        "([I[F)I",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getRanges },
+    { "native_getPictureAdjustmentValues",
+        "([F)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getPictureAdjustmentValues },
+    { "native_getDefaultPictureAdjustmentValues",
+        "([F)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_getDefaultPictureAdjustmentValues },
+    { "native_setPictureAdjustmentValues",
+        "([F)Z",
+        (void *)org_cyanogenmod_hardware_LiveDisplayVendorImpl_setPictureAdjustmentValues },
 };
 
-
 static int register_org_cyanogenmod_hardware_LiveDisplayVendorImpl(JNIEnv *env)
 {
     FIND_CLASS(gDisplayModeClass.clazz,
@@ -388,8 +739,6 @@ static int register_org_cyanogenmod_hardware_LiveDisplayVendorImpl(JNIEnv *env)
 
     FIND_CLASS(gHSICClass.clazz,
             "cyanogenmod/hardware/HSIC");
-    GET_METHOD_ID(gHSICClass.constructor,
-            gHSICClass.clazz, "<init>", "(FFFFF)V");
     GET_FIELD_ID(gHSICClass.mHue,
             gHSICClass.clazz, "mHue", "F");
     GET_FIELD_ID(gHSICClass.mSaturation,
@@ -401,20 +750,6 @@ static int register_org_cyanogenmod_hardware_LiveDisplayVendorImpl(JNIEnv *env)
     GET_FIELD_ID(gHSICClass.mSaturationThreshold,
             gHSICClass.clazz, "mSaturationThreshold", "F");
 
-    FIND_CLASS(gRangeClass.clazz,
-            "android/util/Range");
-    GET_METHOD_ID(gRangeClass.constructor,
-            gRangeClass.clazz, "<init>", "(Ljava/lang/Comparable;Ljava/lang/Comparable;)V");
-
-    FIND_CLASS(gFloatClass.clazz, "java/lang/Float");
-    GET_METHOD_ID(gFloatClass.constructor,
-            gFloatClass.clazz, "<init>", "(F)V");
-
-    FIND_CLASS(gIntegerClass.clazz, "java/lang/Integer");
-    GET_METHOD_ID(gIntegerClass.constructor,
-            gIntegerClass.clazz, "<init>", "(I)V");
-
-
     int rc = jniRegisterNativeMethods(env,
             "org/cyanogenmod/hardware/LiveDisplayVendorImpl",
             gLiveDisplayVendorImplMethods,
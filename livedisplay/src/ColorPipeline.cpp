@@ -0,0 +1,154 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <math.h>
+
+#include "ColorPipeline.h"
+#include "ColorTemperature.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+// BT.601 luma weights
+#define LUMA_R 0.299f
+#define LUMA_G 0.587f
+#define LUMA_B 0.114f
+
+namespace android {
+
+using namespace simd;
+
+ColorPipeline::ColorPipeline()
+    : mHueCos(1.0f),
+      mHueSin(0.0f),
+      mSaturation(1.0f),
+      mThreshold(0.0f),
+      mContrast(1.0f),
+      mIntensity(0.0f) {
+    setGains(1.0f, 1.0f, 1.0f);
+}
+
+void ColorPipeline::setPictureAdjustment(const HSIC& hsic, const HSICRanges& ranges) {
+    float hue = ranges.hue.normalize(hsic.hue) * (float)M_PI;
+    float threshold = std::max(ranges.saturationThreshold.normalize(hsic.saturationThreshold),
+                               0.0f);
+
+    mHueCos = cosf(hue);
+    mHueSin = sinf(hue);
+    mSaturation = 1.0f + ranges.saturation.normalize(hsic.saturation);
+    mThreshold = threshold * threshold;
+    mContrast = 1.0f + ranges.contrast.normalize(hsic.contrast);
+    mIntensity = 0.5f * ranges.intensity.normalize(hsic.intensity);
+}
+
+void ColorPipeline::setColorBalance(int32_t balance, const Range& range) {
+    ColorTemperature temperature;
+    temperature.setRange(range);
+    ColorTemperature::toGains(temperature.toKelvin(balance), mGains);
+}
+
+void ColorPipeline::setGains(float red, float green, float blue) {
+    mGains[0] = red;
+    mGains[1] = green;
+    mGains[2] = blue;
+}
+
+void ColorPipeline::processRows(const uint8_t* src, uint8_t* dst, uint32_t width,
+                                uint32_t first, uint32_t last, uint32_t stride) const {
+    const f32x4 vCos = splat(mHueCos);
+    const f32x4 vSin = splat(mHueSin);
+    const f32x4 vSaturation = splat(mSaturation);
+    const f32x4 vThreshold = splat(mThreshold);
+    const f32x4 vContrast = splat(mContrast);
+    const f32x4 vOffset = splat(0.5f - 0.5f * mContrast + mIntensity);
+    const f32x4 vGainR = splat(mGains[0] * 255.0f);
+    const f32x4 vGainG = splat(mGains[1] * 255.0f / LUMA_G);
+    const f32x4 vGainB = splat(mGains[2] * 255.0f);
+    const f32x4 vLumaR = splat(LUMA_R);
+    const f32x4 vLumaG = splat(LUMA_G);
+    const f32x4 vLumaB = splat(LUMA_B);
+    const f32x4 vNorm = splat(1.0f / 255.0f);
+    const f32x4 vOne = splat(1.0f);
+    const f32x4 vZero = splat(0.0f);
+    const f32x4 vMax = splat(255.0f);
+    const f32x4 vHalf = splat(0.5f);
+
+    float r[4], g[4], b[4];
+    int32_t outR[4], outG[4], outB[4];
+
+    for (uint32_t y = first; y < last; y++) {
+        const uint8_t* in = src + (size_t)y * stride * 4;
+        uint8_t* out = dst + (size_t)y * stride * 4;
+
+        for (uint32_t x = 0; x < width; x += 4) {
+            uint32_t n = std::min(width - x, 4u);
+            for (uint32_t i = 0; i < 4; i++) {
+                const uint8_t* p = in + (x + std::min(i, n - 1)) * 4;
+                r[i] = p[0];
+                g[i] = p[1];
+                b[i] = p[2];
+            }
+
+            f32x4 R = mul(load(r), vNorm);
+            f32x4 G = mul(load(g), vNorm);
+            f32x4 B = mul(load(b), vNorm);
+
+            // luma and chroma differences
+            f32x4 Y = mad(R, vLumaR, mad(G, vLumaG, mul(B, vLumaB)));
+            f32x4 U = sub(B, Y);
+            f32x4 V = sub(R, Y);
+
+            // hue rotation, then saturation above the threshold
+            f32x4 U2 = sub(mul(U, vCos), mul(V, vSin));
+            f32x4 V2 = mad(U, vSin, mul(V, vCos));
+            f32x4 chroma = mad(U2, U2, mul(V2, V2));
+            f32x4 scale = select(greater(chroma, vThreshold), vSaturation, vOne);
+            U2 = mul(U2, scale);
+            V2 = mul(V2, scale);
+
+            // contrast around mid-gray, then intensity
+            Y = mad(Y, vContrast, vOffset);
+
+            R = add(Y, V2);
+            B = add(Y, U2);
+            G = sub(Y, mad(R, vLumaR, mul(B, vLumaB)));
+
+            storeInt(outR, truncate(add(clamp(mul(R, vGainR), vZero, vMax), vHalf)));
+            storeInt(outG, truncate(add(clamp(mul(G, vGainG), vZero, vMax), vHalf)));
+            storeInt(outB, truncate(add(clamp(mul(B, vGainB), vZero, vMax), vHalf)));
+
+            for (uint32_t i = 0; i < n; i++) {
+                uint8_t* p = out + (x + i) * 4;
+                p[3] = in[(x + i) * 4 + 3];
+                p[0] = outR[i];
+                p[1] = outG[i];
+                p[2] = outB[i];
+            }
+        }
+    }
+}
+
+status_t ColorPipeline::process(const uint8_t* src, uint8_t* dst, uint32_t width,
+                                uint32_t height, uint32_t stride, uint32_t threads) const {
+    if (src == NULL || dst == NULL || stride < width) {
+        return BAD_VALUE;
+    }
+
+    parallelFor(height, threads, [=](uint32_t, uint32_t first, uint32_t last) {
+        processRows(src, dst, width, first, last, stride);
+    });
+    return OK;
+}
+};
@@ -0,0 +1,89 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "ColorTemperature.h"
+
+namespace android {
+
+constexpr int ColorTemperature::NUM_STEPS;
+
+void ColorTemperature::setRange(const Range& range) {
+    const int64_t neutral = warmthAt(COLOR_TEMPERATURE_NEUTRAL);
+    const int64_t warmest = warmthAt(COLOR_TEMPERATURE_MIN) - neutral;
+    const int64_t coolest = warmthAt(COLOR_TEMPERATURE_MAX) - neutral;
+
+    mRange = range;
+
+    for (int i = 0; i < NUM_STEPS; i++) {
+        int64_t w = warmthAt(COLOR_TEMPERATURE_MIN + i * COLOR_TEMPERATURE_STEP) - neutral;
+        if (w < 0) {
+            mBalance[i] = (int32_t)(w * range.min / warmest);
+        } else {
+            mBalance[i] = (int32_t)(w * range.max / coolest);
+        }
+    }
+}
+
+static void lightAt(int32_t kelvin, float rgb[3]) {
+    int i = 1;
+    while (i < NUM_LIGHT_SOURCES - 1 && kelvin > LIGHT_SOURCES[i].kelvin) {
+        i++;
+    }
+
+    const LightSource& a = LIGHT_SOURCES[i - 1];
+    const LightSource& b = LIGHT_SOURCES[i];
+    float t = (float)(kelvin - a.kelvin) / (b.kelvin - a.kelvin);
+    for (int c = 0; c < 3; c++) {
+        rgb[c] = a.rgb[c] + (b.rgb[c] - a.rgb[c]) * t;
+    }
+}
+
+void ColorTemperature::toGains(int32_t kelvin, float gains[3]) {
+    float white[3];
+    float max = 0.0f;
+
+    lightAt(COLOR_TEMPERATURE_NEUTRAL, white);
+    lightAt(std::min(std::max(kelvin, COLOR_TEMPERATURE_MIN), COLOR_TEMPERATURE_MAX), gains);
+
+    for (int c = 0; c < 3; c++) {
+        gains[c] /= white[c];
+        max = std::max(max, gains[c]);
+    }
+    for (int c = 0; c < 3; c++) {
+        gains[c] /= max;
+    }
+}
+
+int32_t ColorTemperature::toKelvin(int32_t balance) const {
+    const int32_t* end = mBalance + NUM_STEPS;
+    const int32_t* it = std::lower_bound(mBalance, end, balance);
+
+    if (it == mBalance) {
+        return COLOR_TEMPERATURE_MIN;
+    }
+    if (it == end) {
+        return COLOR_TEMPERATURE_MAX;
+    }
+
+    int32_t i = it - mBalance - 1;
+    int32_t kelvin = COLOR_TEMPERATURE_MIN + i * COLOR_TEMPERATURE_STEP;
+    int32_t span = mBalance[i + 1] - mBalance[i];
+    if (span > 0) {
+        kelvin += (balance - mBalance[i]) * COLOR_TEMPERATURE_STEP / span;
+    }
+    return kelvin;
+}
+};
@@ -0,0 +1,71 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "DisplayPlan.h"
+
+namespace android {
+
+void DisplayPlan::build(const DisplayState& current, const DisplayState& target) {
+    mTarget = target;
+    mSize = 0;
+    mSkipped = 0;
+
+    bool modeChanged = false;
+    if (target.has(Feature::DISPLAY_MODES)) {
+        if (current.has(Feature::DISPLAY_MODES) && current.modeId == target.modeId) {
+            mSkipped++;
+        } else {
+            add(Feature::DISPLAY_MODES);
+            modeChanged = true;
+        }
+    }
+
+    if (target.has(Feature::PICTURE_ADJUSTMENT)) {
+        if (!modeChanged && current.has(Feature::PICTURE_ADJUSTMENT) &&
+                current.pictureAdjustment == target.pictureAdjustment) {
+            mSkipped++;
+        } else {
+            add(Feature::PICTURE_ADJUSTMENT);
+        }
+    }
+
+    if (target.has(Feature::COLOR_TEMPERATURE)) {
+        if (current.has(Feature::COLOR_TEMPERATURE) &&
+                current.colorBalance == target.colorBalance) {
+            mSkipped++;
+        } else {
+            add(Feature::COLOR_TEMPERATURE);
+        }
+    }
+
+    if (target.has(Feature::OUTDOOR_MODE)) {
+        if (current.has(Feature::OUTDOOR_MODE) && current.outdoorMode == target.outdoorMode) {
+            mSkipped++;
+        } else {
+            add(Feature::OUTDOOR_MODE);
+        }
+    }
+
+    if (target.has(Feature::ADAPTIVE_BACKLIGHT)) {
+        if (current.has(Feature::ADAPTIVE_BACKLIGHT) &&
+                current.adaptiveBacklight == target.adaptiveBacklight) {
+            mSkipped++;
+        } else {
+            add(Feature::ADAPTIVE_BACKLIGHT);
+        }
+    }
+}
+};
@@ -0,0 +1,76 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "GammaLut.h"
+#include "Simd.h"
+
+namespace android {
+
+using namespace simd;
+
+static void generateChannel(uint16_t* out, size_t size, float gamma, float gain, float contrast,
+                            float intensity) {
+    const float maxValue = (float)(size - 1);
+
+    // y = ((x^gamma - 0.5) * (1 + contrast) + 0.5 + intensity / 2) * gain
+    const f32x4 vGamma = splat(gamma);
+    const f32x4 vSlope = splat((1.0f + contrast) * gain);
+    const f32x4 vOffset = splat((0.5f - 0.5f * (1.0f + contrast) + 0.5f * intensity) * gain);
+    const f32x4 vScale = splat(1.0f / maxValue);
+    const f32x4 vMax = splat(maxValue);
+    const f32x4 vZero = splat(0.0f);
+    const f32x4 vHalf = splat(0.5f);
+    const f32x4 vStep = splat(4.0f);
+
+    const float base[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    f32x4 index = load(base);
+    int32_t tmp[4];
+
+    for (size_t i = 0; i < size; i += 4) {
+        f32x4 y = pow(mul(index, vScale), vGamma);
+        y = mad(y, vSlope, vOffset);
+        y = clamp(mul(y, vMax), vZero, vMax);
+        storeInt(tmp, truncate(add(y, vHalf)));
+
+        out[i] = tmp[0];
+        out[i + 1] = tmp[1];
+        out[i + 2] = tmp[2];
+        out[i + 3] = tmp[3];
+
+        index = add(index, vStep);
+    }
+}
+
+status_t GammaLut::generate(size_t size, const LutParams& params) {
+    if (size != 256 && size != 1024 && size != 4096) {
+        return BAD_VALUE;
+    }
+
+    // Check everything first so a bad channel leaves the table untouched
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+        // Written so NaN is rejected too
+        if (!(params.gamma[c] > 0.0f)) {
+            return BAD_VALUE;
+        }
+    }
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+        generateChannel(mTable[c], size, params.gamma[c], params.gain[c], params.contrast,
+                        params.intensity);
+    }
+    mSize = size;
+    return OK;
+}
+};
@@ -17,31 +17,61 @@
 #define LOG_TAG "LiveDisplay-HW"
 
 #include <cutils/properties.h>
-#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/Timers.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "LiveDisplay.h"
 
-#include "LegacyMM.h"
-#include "SDM.h"
+#include "Parallel.h"
+#include "RemoteBackend.h"
+#include "SettingsStore.h"
+
+#define FB0_BLANK_EVENT "/sys/class/graphics/fb0/show_blank_event"
+
+// Backend calls are retried this many times, waiting twice as long each time
+#define RETRY_LIMIT 2
+#define RETRY_DELAY_US 1000
+
+// Delay before reconnecting after a reset, doubled for each reset in a row
+#define BACKOFF_MIN_MS 100u
+#define BACKOFF_MAX_MS 30000u
+
+// Deadlines for a single backend call, after which it is considered stuck
+#define CALL_TIMEOUT_MS 2000
+#define INIT_TIMEOUT_MS 5000
+
+// Set once the saved state has been applied since boot
+#define RESTORED_PROPERTY "sys.livedisplay.restored"
 
 namespace android {
 
 ANDROID_SINGLETON_STATIC_INSTANCE(LiveDisplay)
 
-LiveDisplay::LiveDisplay() : mConnected(false), mBackend(NULL) {
-    char board[PROPERTY_VALUE_MAX];
-    property_get("ro.board.platform", board, NULL);
-
-    if (!strcmp(board, "msm8916") || !strcmp(board, "msm8939") || !strcmp(board, "msm8992") ||
-        !strcmp(board, "msm8974") || !strcmp(board, "msm8994")) {
-        mBackend = new LegacyMM();
-    } else if (!strcmp(board, "msm8996") || !strcmp(board, "msm8937") ||
-               !strcmp(board, "msm8953") || !strcmp(board, "msm8976")) {
-        mBackend = new SDM();
-    } else {
-        mBackend = NULL;
-        return;
-    }
+LiveDisplay::LiveDisplay()
+    : mConnected(false),
+      mScreenOn(true),
+      mBackoffMs(0),
+      mRetryAt(0),
+      mGeneration(0),
+      mModeRecordCount(0),
+      mModeRecordsGeneration(0),
+      mColorTemperatureKelvin(COLOR_TEMPERATURE_NEUTRAL),
+      mBackend(NULL),
+      mRecoveries(0) {
+    mColorTemperatureShadow.write(-1);
+
+    // livedisplayd owns the vendor backend, see PlatformBackend.h
+    mBackend = new RemoteBackend();
     ALOGD("Loaded LiveDisplay native interface");
 }
 
@@ -51,19 +81,138 @@ LiveDisplay::~LiveDisplay() {
 
 void LiveDisplay::reset() {
     if (mConnected) {
-        mBackend->deinitialize();
+        call([=] { return mBackend->deinitialize(); }, CALL_TIMEOUT_MS);
     }
     mFeatures = 0;
     mConnected = false;
+    mColorTemperature.setRange(Range());
+    mCurrent = DisplayState();
+    // The shared page keeps the last applied state, the panel still shows it
+    updateShadow(mDeferred);
+    mCapabilities.write(Capabilities());
+}
+
+/*
+ * Failures worth retrying. Bad requests fail the same way every time,
+ * and nothing can be done with a backend that is stuck in a call.
+ */
+static bool isTransient(status_t rc) {
+    return rc != OK && rc != BAD_VALUE && rc != INVALID_OPERATION && rc != NAME_NOT_FOUND &&
+           rc != TIMED_OUT;
 }
 
-void LiveDisplay::error(const char* msg, ...) {
-    if (msg != NULL) {
-        va_list args;
-        ALOGE(msg, args);
+void LiveDisplay::error(status_t rc, const char* msg) {
+    ALOGE("%s (%d)", msg, rc);
+    if (!isTransient(rc)) {
+        return;
     }
 
+    // Retries and a reconnect already failed, start over from scratch
+    mStats.resets++;
     reset();
+    backoff();
+}
+
+void LiveDisplay::backoff() {
+    mBackoffMs = mBackoffMs == 0 ? BACKOFF_MIN_MS : std::min(mBackoffMs * 2, BACKOFF_MAX_MS);
+    mRetryAt = systemTime() + ms2ns(mBackoffMs);
+    ALOGW("Backend unavailable for %ums", mBackoffMs);
+}
+
+/*
+ * Brings the backend back up without probing it again, as the features
+ * and ranges it reported can't have changed. What the hardware is set
+ * to is unknown afterwards.
+ */
+bool LiveDisplay::reconnect() {
+    mStats.reconnects++;
+    call([=] { return mBackend->deinitialize(); }, CALL_TIMEOUT_MS);
+    if (call([=] { return mBackend->initialize(); }, INIT_TIMEOUT_MS) != OK) {
+        mConnected = false;
+        return false;
+    }
+    mCurrent = DisplayState();
+    publishCurrent();
+    return true;
+}
+
+/*
+ * Runs a single backend call on the executor. Once a stuck call has
+ * returned, nothing is known about what the hardware is set to.
+ */
+template <typename F>
+status_t LiveDisplay::call(F op, uint32_t timeoutMs) {
+    uint32_t recoveries = mExecutor.recoveries();
+    if (recoveries != mRecoveries) {
+        mRecoveries = recoveries;
+        mCurrent = DisplayState();
+        publishCurrent();
+    }
+    return mExecutor.run(op, ms2ns(timeoutMs));
+}
+
+/*
+ * Runs a backend call, retrying transient failures after a short and
+ * growing delay, then once more after a light reconnect.
+ */
+template <typename F>
+status_t LiveDisplay::invoke(F op) {
+    if (!mConnected) {
+        // A reconnect earlier in the same plan failed
+        return NO_INIT;
+    }
+
+    status_t rc = call(op, CALL_TIMEOUT_MS);
+    for (uint32_t i = 0; isTransient(rc) && i < RETRY_LIMIT; i++) {
+        usleep(RETRY_DELAY_US << i);
+        mStats.retries++;
+        rc = call(op, CALL_TIMEOUT_MS);
+    }
+    if (isTransient(rc) && reconnect()) {
+        rc = call(op, CALL_TIMEOUT_MS);
+    }
+    if (rc == OK) {
+        mBackoffMs = 0;
+    }
+    return rc;
+}
+
+/*
+ * Runs a backend call which fills in a result. The call works on a heap
+ * copy, so if it gets stuck and returns after its caller gave up, it
+ * doesn't write to a stack frame which is gone.
+ */
+template <typename T, typename F>
+status_t LiveDisplay::fetch(T& out, F op) {
+    std::shared_ptr<T> result = std::make_shared<T>(out);
+    status_t rc = invoke([result, op] { return op(*result); });
+    if (rc == OK) {
+        out = *result;
+    }
+    return rc;
+}
+
+/*
+ * Asks the backend about every feature, each on its own thread where
+ * the backend allows it. Most of the time goes to round trips into the
+ * vendor service, which overlap well.
+ */
+static uint32_t probeFeatures(LiveDisplayBackend* backend) {
+    std::vector<Feature> probes;
+    for (uint32_t i = 1; i <= (uint32_t)Feature::MAX; i <<= 1) {
+        probes.push_back(static_cast<Feature>(i));
+    }
+
+    std::atomic<uint32_t> found(0);
+    uint32_t threads = backend->supportsConcurrentProbe() ? probes.size() : 1;
+    parallelFor(probes.size(), threads, [&](uint32_t, uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; i++) {
+            if (backend->hasFeature(probes[i])) {
+                found |= (uint32_t)probes[i];
+            }
+        }
+    });
+    return found;
 }
 
 bool LiveDisplay::connect() {
@@ -77,31 +226,618 @@ bool LiveDisplay::connect() {
         return false;
     }
 
-    if (mBackend->initialize() != OK) {
-        ALOGE("Failed to initialize backend!");
+    if (mRetryAt != 0 && systemTime() < mRetryAt) {
+        mStats.backoffSkips++;
         return false;
     }
+    mRetryAt = 0;
 
-    for (uint32_t i = 1; i <= (uint32_t)Feature::MAX; i <<= 1) {
-        Feature f = static_cast<Feature>(i);
-        if (mBackend->hasFeature(f)) {
-            addFeature(f);
-        }
+    if (call([=] { return mBackend->initialize(); }, INIT_TIMEOUT_MS) != OK) {
+        ALOGE("Failed to initialize backend!");
+        backoff();
+        return false;
     }
     mConnected = true;
 
+    // Only one process publishes, the others map the page read only
+    status_t pageRc = mStatePage.openForWrite();
+    if (pageRc != OK && pageRc != WOULD_BLOCK) {
+        ALOGE("Unable to open the shared state page: %d", pageRc);
+    }
+
+    nsecs_t start = systemTime();
+    uint32_t features = 0;
+    status_t rc = fetch(features, [=](uint32_t& out) {
+        out = probeFeatures(mBackend);
+        return OK;
+    });
+    if (rc != OK) {
+        // Only a complete probe is worth caching
+        ALOGE("Failed to probe backend features!");
+        reset();
+        backoff();
+        return false;
+    }
+    mFeatures = features;
+    mStats.lastProbeUs = ns2us(systemTime() - start);
+    ALOGD("Probed features 0x%x in %uus", mFeatures, mStats.lastProbeUs);
+
+    publishCapabilities();
+
+    restoreState();
+    primeShadow();
+
     return mFeatures > 0;
 }
 
-uint32_t LiveDisplay::getSupportedFeatures() {
+void LiveDisplay::publishCapabilities() {
+    Capabilities caps;
+    caps.valid = true;
+    caps.generation = ++mGeneration;
+    caps.features = mFeatures;
+
+    if ((mFeatures & Feature::COLOR_TEMPERATURE) &&
+            fetch(caps.colorBalance, [=](Range& range) {
+                return mBackend->getColorBalanceRange(range);
+            }) == OK) {
+        caps.ranges |= Feature::COLOR_TEMPERATURE;
+        mColorTemperature.setRange(caps.colorBalance);
+        caps.colorTemperature = mColorTemperature.isValid();
+    }
+    if ((mFeatures & Feature::PICTURE_ADJUSTMENT) &&
+            fetch(caps.pictureAdjustment, [=](HSICRanges& ranges) {
+                return mBackend->getPictureAdjustmentRanges(ranges);
+            }) == OK) {
+        caps.ranges |= Feature::PICTURE_ADJUSTMENT;
+    }
+
+    mCapabilities.write(caps);
+}
+
+bool LiveDisplay::getCapabilities(Capabilities& caps) {
+    caps = mCapabilities.read();
+    if (caps.valid) {
+        return true;
+    }
+
+    Mutex::Autolock _l(mLock);
     connect();
-    return mFeatures;
+    caps = mCapabilities.read();
+    return caps.valid;
+}
+
+void LiveDisplay::restoreState() {
+    SettingsStore& store = SettingsStore::getInstance();
+    DisplayState state;
+    status_t rc = store.getState(state);
+    if (rc != OK) {
+        if (rc != NAME_NOT_FOUND) {
+            ALOGE("Discarding saved state: %d", rc);
+        }
+        state = DisplayState();
+    }
+
+    // A single mode is applied, the one saved with the state or the default
+    int32_t modeId = -1;
+    if (!state.has(Feature::DISPLAY_MODES) && store.getModeId(modeId) == OK && modeId >= 0) {
+        state.modeId = modeId;
+        state.features |= Feature::DISPLAY_MODES;
+    }
+
+    state.features &= mFeatures;
+    if (state.features == 0) {
+        return;
+    }
+    mState = state;
+
+    // The panel keeps it across reconnects and other processes connecting
+    char restored[PROPERTY_VALUE_MAX];
+    property_get(RESTORED_PROPERTY, restored, "0");
+    if (!strcmp(restored, "1")) {
+        return;
+    }
+
+    DisplayPlan plan;
+    plan.build(mCurrent, withLayers(state));
+
+    uint32_t failed = 0;
+    applyPlan(plan, failed);
+    if (failed != 0) {
+        ALOGE("Failed to restore features 0x%x", failed);
+        mState.features &= ~failed;
+        return;
+    }
+    property_set(RESTORED_PROPERTY, "1");
+}
+
+// Reads what the restore left unknown, for the lock free getters
+void LiveDisplay::primeShadow() {
+    uint32_t missing = mFeatures & ~mCurrent.features;
+
+    if ((missing & Feature::COLOR_TEMPERATURE) &&
+            fetchColorBalance(mCurrent.colorBalance) == OK) {
+        mCurrent.features |= Feature::COLOR_TEMPERATURE;
+    }
+    if ((missing & Feature::OUTDOOR_MODE) &&
+            fetch(mCurrent.outdoorMode, [=](bool& out) {
+                out = mBackend->isOutdoorModeEnabled();
+                return OK;
+            }) == OK) {
+        mCurrent.features |= Feature::OUTDOOR_MODE;
+    }
+    if ((missing & Feature::ADAPTIVE_BACKLIGHT) &&
+            fetch(mCurrent.adaptiveBacklight, [=](bool& out) {
+                out = mBackend->isAdaptiveBacklightEnabled();
+                return OK;
+            }) == OK) {
+        mCurrent.features |= Feature::ADAPTIVE_BACKLIGHT;
+    }
+    publishCurrent();
+}
+
+status_t LiveDisplay::applyPlan(const DisplayPlan& plan, uint32_t& failed) {
+    const DisplayState& target = plan.target();
+    status_t result = OK;
+    failed = 0;
+
+    for (uint32_t i = 0; i < plan.size(); i++) {
+        Feature f = plan.at(i);
+        status_t rc = BAD_VALUE;
+
+        switch (f) {
+            case Feature::DISPLAY_MODES:
+                rc = invoke([=] { return mBackend->setDisplayMode(target.modeId, false); });
+                if (rc == OK) {
+                    mCurrent.modeId = target.modeId;
+                    mCurrent.features &= ~Feature::PICTURE_ADJUSTMENT;
+                }
+                break;
+            case Feature::PICTURE_ADJUSTMENT:
+                rc = invoke([=] {
+                    return mBackend->setPictureAdjustment(target.pictureAdjustment);
+                });
+                if (rc == OK) {
+                    mCurrent.pictureAdjustment = target.pictureAdjustment;
+                }
+                break;
+            case Feature::COLOR_TEMPERATURE:
+                rc = invoke([=] { return mBackend->setColorBalance(target.colorBalance); });
+                if (rc == OK) {
+                    mCurrent.colorBalance = target.colorBalance;
+                }
+                break;
+            case Feature::OUTDOOR_MODE:
+                rc = invoke([=] { return mBackend->setOutdoorModeEnabled(target.outdoorMode); });
+                if (rc == OK) {
+                    mCurrent.outdoorMode = target.outdoorMode;
+                }
+                break;
+            case Feature::ADAPTIVE_BACKLIGHT:
+                rc = invoke([=] {
+                    return mBackend->setAdaptiveBacklightEnabled(target.adaptiveBacklight);
+                });
+                if (rc == OK) {
+                    mCurrent.adaptiveBacklight = target.adaptiveBacklight;
+                }
+                break;
+        }
+
+        if (rc == OK) {
+            mCurrent.features |= f;
+        } else {
+            mCurrent.features &= ~f;
+            failed |= f;
+            if (result == OK) {
+                result = rc;
+            }
+        }
+    }
+
+    publishCurrent();
+
+    mStats.plans++;
+    mStats.lastPlanSize = plan.size();
+    mStats.planOps += plan.size();
+    mStats.skippedOps += plan.skipped();
+    ALOGV("Applied plan of %u ops, %u skipped", plan.size(), plan.skipped());
+    return result;
+}
+
+void LiveDisplay::publishCurrent() {
+    DisplayState visible = mCurrent;
+    visible.merge(mDeferred);
+    updateShadow(visible);
+    mStatePage.publish(visible);
+}
+
+// The color temperature is worked out here so its getter needs no lock
+void LiveDisplay::updateShadow(const DisplayState& visible) {
+    mCurrentShadow.write(visible);
+
+    int32_t kelvin = -1;
+    if (visible.has(Feature::COLOR_TEMPERATURE) && mColorTemperature.isValid()) {
+        kelvin = toColorTemperature(visible.colorBalance);
+    }
+    mColorTemperatureShadow.write(kelvin);
+}
+
+// A client layer decides this setting, so only the user's value changes
+bool LiveDisplay::isLayered(const DisplayState& change) {
+    return (change.features & ~mArbiter.layered()) == 0;
+}
+
+// state with every setting a client layer decides replaced by the layer's
+DisplayState LiveDisplay::withLayers(const DisplayState& state) {
+    DisplayState layered = mArbiter.resolved();
+    layered.features &= mArbiter.layered();
+
+    DisplayState target = state;
+    target.features &= ~layered.features;
+    target.merge(layered);
+    return target;
+}
+
+bool LiveDisplay::deferWhileOff(const DisplayState& change) {
+    if (mScreenOn) {
+        // Applied now, so it replaces anything still queued from before
+        mDeferred.features &= ~change.features;
+        return false;
+    }
+    mDeferred.merge(change);
+    mStats.deferredSettings++;
+    publishCurrent();
+    return true;
+}
+
+status_t LiveDisplay::setScreenOn(bool on) {
+    Mutex::Autolock _l(mLock);
+
+    // Another screen on also retries whatever failed to apply last time
+    if (on == mScreenOn && (!on || mDeferred.features == 0)) {
+        return OK;
+    }
+    mScreenOn = on;
+    if (!on || mDeferred.features == 0) {
+        return OK;
+    }
+
+    // The deferred settings stay queued until the backend has taken them
+    if (!connect()) {
+        return NO_INIT;
+    }
+
+    DisplayState target = mDeferred;
+    target.features &= mFeatures;
+
+    DisplayPlan plan;
+    plan.build(mCurrent, target);
+
+    uint32_t failed = 0;
+    status_t rc = applyPlan(plan, failed);
+    mStats.deferredCommits++;
+
+    mDeferred.features &= failed;
+    publishCurrent();
+    if (rc != OK) {
+        error(rc, "Unable to apply deferred settings!");
+    }
+    return rc;
+}
+
+bool LiveDisplay::isScreenOn() {
+    Mutex::Autolock _l(mLock);
+    return mScreenOn;
+}
+
+void LiveDisplay::monitorScreenState() {
+    int fd = open(FB0_BLANK_EVENT, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGW("Unable to follow the panel state: %s", strerror(errno));
+        return;
+    }
+
+    char buf[64];
+    while (true) {
+        // sysfs attributes have to be read again from the start to rearm poll
+        ssize_t len = TEMP_FAILURE_RETRY(pread(fd, buf, sizeof(buf) - 1, 0));
+        if (len <= 0) {
+            break;
+        }
+        buf[len] = '\0';
+
+        int on;
+        if (sscanf(buf, "panel_power_on = %d", &on) == 1) {
+            setScreenOn(on != 0);
+        }
+
+        struct pollfd p = {.fd = fd, .events = POLLPRI | POLLERR, .revents = 0};
+        if (poll(&p, 1, -1) < 0 && errno != EINTR) {
+            break;
+        }
+    }
+
+    ALOGE("Stopped following the panel state");
+    close(fd);
+}
+
+void LiveDisplay::saveState() {
+    status_t rc = SettingsStore::getInstance().setState(mState);
+    if (rc != OK) {
+        ALOGE("Failed to save state: %d", rc);
+    }
+}
+
+uint32_t LiveDisplay::getDisplayModesGeneration() {
+    Capabilities caps;
+    return getCapabilities(caps) ? caps.generation : 0;
+}
+
+uint32_t LiveDisplay::getSupportedFeatures() {
+    Capabilities caps;
+    getCapabilities(caps);
+    return caps.features;
+}
+
+const int32_t LiveDisplay::PEEK_UNKNOWN;
+
+int32_t LiveDisplay::peekSupportedFeatures() {
+    Capabilities caps = mCapabilities.read();
+    return caps.valid ? (int32_t)caps.features : PEEK_UNKNOWN;
+}
+
+int32_t LiveDisplay::peekColorBalance() {
+    DisplayState current = mCurrentShadow.read();
+    return current.has(Feature::COLOR_TEMPERATURE) ? current.colorBalance : PEEK_UNKNOWN;
+}
+
+int32_t LiveDisplay::peekColorTemperature() {
+    int32_t kelvin = mColorTemperatureShadow.read();
+    return kelvin >= 0 ? kelvin : PEEK_UNKNOWN;
+}
+
+int32_t LiveDisplay::peekOutdoorMode() {
+    DisplayState current = mCurrentShadow.read();
+    return current.has(Feature::OUTDOOR_MODE) ? current.outdoorMode : PEEK_UNKNOWN;
+}
+
+int32_t LiveDisplay::peekAdaptiveBacklight() {
+    DisplayState current = mCurrentShadow.read();
+    return current.has(Feature::ADAPTIVE_BACKLIGHT) ? current.adaptiveBacklight : PEEK_UNKNOWN;
 }
 
 bool LiveDisplay::check(Feature f) {
     return hasFeature(f) && connect();
 }
 
+status_t LiveDisplay::setGammaLut(const GammaLut& lut) {
+    status_t rc = NO_INIT;
+    Mutex::Autolock _l(mLock);
+
+    if (connect()) {
+        std::shared_ptr<GammaLut> copy = std::make_shared<GammaLut>(lut);
+        rc = invoke([=] { return mBackend->setGammaLut(*copy); });
+        if (rc != OK && rc != INVALID_OPERATION) {
+            error(rc, "Unable to set gamma table!");
+        }
+    }
+    return rc;
+}
+
+status_t LiveDisplay::applyState(const DisplayState& target) {
+    status_t rc = NO_INIT;
+    Mutex::Autolock _l(mLock);
+
+    if (connect()) {
+        DisplayState state = target;
+        state.features &= mFeatures;
+        state = withLayers(state);
+        if (deferWhileOff(state)) {
+            return OK;
+        }
+
+        DisplayPlan plan;
+        plan.build(mCurrent, state);
+
+        uint32_t failed = 0;
+        rc = applyPlan(plan, failed);
+        if (rc != OK) {
+            error(rc, "Unable to apply display state!");
+        }
+    }
+    return rc;
+}
+
+status_t LiveDisplay::setProfile(int32_t id, const DisplayState& state) {
+    Mutex::Autolock _l(mLock);
+
+    if (!connect()) {
+        return NO_INIT;
+    }
+
+    DisplayState profile = state;
+    profile.features &= mFeatures;
+    mProfiles.put(id, profile);
+    return OK;
+}
+
+status_t LiveDisplay::removeProfile(int32_t id) {
+    Mutex::Autolock _l(mLock);
+    return mProfiles.remove(id);
+}
+
+status_t LiveDisplay::applyProfile(int32_t id) {
+    nsecs_t start = systemTime();
+    Mutex::Autolock _l(mLock);
+
+    if (!connect()) {
+        return NO_INIT;
+    }
+
+    DisplayState profile;
+    status_t rc = mProfiles.get(id, profile);
+    if (rc != OK) {
+        ALOGE("Unknown profile %d", id);
+        return rc;
+    }
+
+    DisplayPlan plan;
+    plan.build(mCurrent, withLayers(profile));
+    if (deferWhileOff(plan.target())) {
+        return OK;
+    }
+
+    uint32_t failed = 0;
+    rc = applyPlan(plan, failed);
+    if (rc != OK) {
+        error(rc, "Unable to apply profile!");
+        return rc;
+    }
+
+    uint32_t latency = (uint32_t)ns2us(systemTime() - start);
+    mStats.profileSwitches++;
+    mStats.lastProfileLatencyUs = latency;
+    mStats.maxProfileLatencyUs = std::max(mStats.maxProfileLatencyUs, latency);
+    ALOGV("Applied profile %d with %u ops in %uus", id, plan.size(), latency);
+    return OK;
+}
+
+status_t LiveDisplay::setClientLayer(int32_t client, int32_t priority,
+                                     const DisplayState& state) {
+    Mutex::Autolock _l(mLock);
+
+    if (!connect()) {
+        return NO_INIT;
+    }
+
+    DisplayState layer = state;
+    layer.features &= mFeatures;
+
+    uint32_t touched = mArbiter.features(client) | layer.features;
+
+    // The user's settings may have moved since the last resolve
+    mArbiter.setBase(mState);
+    mArbiter.set(client, priority, layer);
+    return applyResolved(client, touched);
+}
+
+status_t LiveDisplay::removeClientLayer(int32_t client) {
+    Mutex::Autolock _l(mLock);
+
+    if (!connect()) {
+        return NO_INIT;
+    }
+
+    uint32_t touched = mArbiter.features(client);
+    mArbiter.setBase(mState);
+    if (!mArbiter.remove(client) && touched == 0) {
+        return NAME_NOT_FOUND;
+    }
+    return applyResolved(client, touched);
+}
+
+/*
+ * Moves the settings a client's layer covered, before or after its
+ * update, to their resolved values. Settings nobody layered are left to
+ * whatever set them last, and ones already in place are skipped.
+ */
+status_t LiveDisplay::applyResolved(int32_t client, uint32_t touched) {
+    DisplayState target = mArbiter.resolved();
+    target.features &= touched;
+
+    // Queued even when it matches mCurrent, to replace anything an earlier
+    // layer queued for these settings while the screen was off
+    if (deferWhileOff(target)) {
+        return OK;
+    }
+
+    DisplayPlan plan;
+    plan.build(mCurrent, target);
+    if (plan.size() == 0) {
+        return OK;
+    }
+
+    uint32_t failed = 0;
+    status_t rc = applyPlan(plan, failed);
+    mArbiter.recordOps(client, plan.size());
+    if (rc != OK) {
+        error(rc, "Unable to apply resolved settings!");
+    }
+    return rc;
+}
+
+status_t LiveDisplay::getClientStats(int32_t client, ClientStats& stats) {
+    Mutex::Autolock _l(mLock);
+    return mArbiter.getStats(client, stats);
+}
+
+status_t LiveDisplay::getState(DisplayState& state, int32_t& kelvin) {
+    Mutex::Autolock _l(mLock);
+
+    state = DisplayState();
+    kelvin = -1;
+
+    if (!connect()) {
+        return NO_INIT;
+    }
+
+    if (mFeatures & Feature::DISPLAY_MODES) {
+        sp<DisplayMode> mode;
+        fetch(mode, [=](sp<DisplayMode>& out) {
+            out = mBackend->getCurrentDisplayMode();
+            return OK;
+        });
+        if (mode != nullptr) {
+            state.modeId = mode->id;
+            state.features |= Feature::DISPLAY_MODES;
+        }
+    }
+    if ((mFeatures & Feature::COLOR_TEMPERATURE) && fetchColorBalance(state.colorBalance) == OK) {
+        state.features |= Feature::COLOR_TEMPERATURE;
+        if (mColorTemperature.isValid()) {
+            kelvin = toColorTemperature(state.colorBalance);
+        }
+    }
+    if ((mFeatures & Feature::PICTURE_ADJUSTMENT) &&
+            fetch(state.pictureAdjustment, [=](HSIC& hsic) {
+                return mBackend->getPictureAdjustment(hsic);
+            }) == OK) {
+        state.features |= Feature::PICTURE_ADJUSTMENT;
+    }
+    if ((mFeatures & Feature::OUTDOOR_MODE) &&
+            fetch(state.outdoorMode, [=](bool& out) {
+                out = mBackend->isOutdoorModeEnabled();
+                return OK;
+            }) == OK) {
+        state.features |= Feature::OUTDOOR_MODE;
+    }
+    if ((mFeatures & Feature::ADAPTIVE_BACKLIGHT) &&
+            fetch(state.adaptiveBacklight, [=](bool& out) {
+                out = mBackend->isAdaptiveBacklightEnabled();
+                return OK;
+            }) == OK) {
+        state.features |= Feature::ADAPTIVE_BACKLIGHT;
+    }
+
+    // Report what the panel will show once it is back on
+    if (mDeferred.features != 0) {
+        state.merge(mDeferred);
+        if (mDeferred.has(Feature::COLOR_TEMPERATURE) && mColorTemperature.isValid()) {
+            kelvin = toColorTemperature(state.colorBalance);
+        }
+    }
+    return OK;
+}
+
+void LiveDisplay::getHealth(BackendHealth& health) {
+    // Deliberately lock free, this has to work while a call is stuck
+    mExecutor.getHealth(health);
+}
+
+void LiveDisplay::getStats(LiveDisplayStats& stats) {
+    Mutex::Autolock _l(mLock);
+    stats = mStats;
+}
+
 //----------------------------------------------------------------------------/
 
 status_t LiveDisplay::getDisplayModes(List<sp<DisplayMode>>& modes) {
@@ -109,32 +845,75 @@ status_t LiveDisplay::getDisplayModes(List<sp<DisplayMode>>& modes) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::DISPLAY_MODES)) {
-        rc = mBackend->getDisplayModes(modes);
+        rc = fetch(modes, [=](List<sp<DisplayMode>>& out) {
+            return mBackend->getDisplayModes(out);
+        });
         if (rc != OK) {
-            error("Unable to fetch display modes!");
+            error(rc, "Unable to fetch display modes!");
         }
     }
     return rc;
 }
 
+status_t LiveDisplay::getDisplayModeRecords(DisplayModeRecord* records, size_t capacity,
+                                            size_t& count) {
+    status_t rc = NO_INIT;
+    Mutex::Autolock _l(mLock);
+
+    count = 0;
+    if (!check(Feature::DISPLAY_MODES)) {
+        return rc;
+    }
+
+    // The list only changes with the backend, so it is fetched once per connect
+    if (mModeRecordsGeneration != mGeneration) {
+        std::vector<DisplayModeRecord> found(MAX_DISPLAY_MODES);
+        rc = fetch(found, [=](std::vector<DisplayModeRecord>& out) {
+            size_t n = 0;
+            status_t ret = mBackend->getDisplayModeRecords(out.data(), out.size(), n);
+            out.resize(n);
+            return ret;
+        });
+        if (rc != OK) {
+            error(rc, "Unable to fetch display modes!");
+            return rc;
+        }
+        mModeRecordCount = found.size();
+        std::copy(found.begin(), found.end(), mModeRecords);
+        mModeRecordsGeneration = mGeneration;
+    }
+
+    count = std::min(capacity, mModeRecordCount);
+    std::copy(mModeRecords, mModeRecords + count, records);
+    return OK;
+}
+
 sp<DisplayMode> LiveDisplay::getDefaultDisplayMode() {
     status_t rc = NO_INIT;
     Mutex::Autolock _l(mLock);
 
+    sp<DisplayMode> mode;
     if (check(Feature::DISPLAY_MODES)) {
-        return mBackend->getDefaultDisplayMode();
+        fetch(mode, [=](sp<DisplayMode>& out) {
+            out = mBackend->getDefaultDisplayMode();
+            return OK;
+        });
     }
-    return nullptr;
+    return mode;
 }
 
 sp<DisplayMode> LiveDisplay::getCurrentDisplayMode() {
     status_t rc = NO_INIT;
     Mutex::Autolock _l(mLock);
 
+    sp<DisplayMode> mode;
     if (check(Feature::DISPLAY_MODES)) {
-        return mBackend->getCurrentDisplayMode();
+        fetch(mode, [=](sp<DisplayMode>& out) {
+            out = mBackend->getCurrentDisplayMode();
+            return OK;
+        });
     }
-    return nullptr;
+    return mode;
 }
 
 status_t LiveDisplay::setDisplayMode(int32_t modeID, bool makeDefault) {
@@ -142,55 +921,180 @@ status_t LiveDisplay::setDisplayMode(int32_t modeID, bool makeDefault) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::DISPLAY_MODES)) {
-        rc = mBackend->setDisplayMode(modeID, makeDefault);
+        // A new default is stored by the backend, so that can't wait
+        DisplayState change;
+        change.features = Feature::DISPLAY_MODES;
+        change.modeId = modeID;
+        if (!makeDefault && (isLayered(change) || deferWhileOff(change))) {
+            return OK;
+        }
+
+        rc = invoke([=] { return mBackend->setDisplayMode(modeID, makeDefault); });
         if (rc != OK) {
-            error("Unable to set display mode!");
+            error(rc, "Unable to set display mode!");
+        } else {
+            mCurrent.modeId = modeID;
+            mCurrent.features |= Feature::DISPLAY_MODES;
+            mCurrent.features &= ~Feature::PICTURE_ADJUSTMENT;
+            publishCurrent();
+            if (makeDefault) {
+                mState.modeId = modeID;
+                mState.features |= Feature::DISPLAY_MODES;
+                saveState();
+            }
         }
     }
     return rc;
 }
 
 status_t LiveDisplay::getColorBalanceRange(Range& range) {
+    Capabilities caps;
+    if (getCapabilities(caps) && (caps.ranges & Feature::COLOR_TEMPERATURE)) {
+        range = caps.colorBalance;
+        return OK;
+    }
+    return NO_INIT;
+}
+
+int LiveDisplay::getColorBalance() {
+    DisplayState current = mCurrentShadow.read();
+    if (current.has(Feature::COLOR_TEMPERATURE)) {
+        return current.colorBalance;
+    }
+
+    Mutex::Autolock _l(mLock);
+
+    if (check(Feature::COLOR_TEMPERATURE) && fetchColorBalance(mCurrent.colorBalance) == OK) {
+        mCurrent.features |= Feature::COLOR_TEMPERATURE;
+        publishCurrent();
+        return mCurrent.colorBalance;
+    }
+
+    return 0;
+}
+
+status_t LiveDisplay::setColorBalance(int value) {
     status_t rc = NO_INIT;
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::COLOR_TEMPERATURE)) {
-        rc = mBackend->getColorBalanceRange(range);
-        if (rc != OK) {
-            error("Unable to fetch color balance range!");
+        DisplayState change;
+        change.features = Feature::COLOR_TEMPERATURE;
+        change.colorBalance = value;
+        if (isLayered(change) || deferWhileOff(change)) {
+            rc = OK;
+        } else {
+            rc = invoke([=] { return mBackend->setColorBalance(value); });
+            if (rc != OK) {
+                error(rc, "Unable to set color balance!");
+                return rc;
+            }
+            mCurrent.colorBalance = value;
+            mCurrent.features |= Feature::COLOR_TEMPERATURE;
+            publishCurrent();
         }
+        mState.colorBalance = value;
+        mState.features |= Feature::COLOR_TEMPERATURE;
+        saveState();
     }
     return rc;
 }
 
-int LiveDisplay::getColorBalance() {
+status_t LiveDisplay::getColorTemperatureRange(Range& range) {
+    Capabilities caps;
+    if (getCapabilities(caps) && caps.colorTemperature) {
+        range.min = COLOR_TEMPERATURE_MIN;
+        range.max = COLOR_TEMPERATURE_MAX;
+        range.step = COLOR_TEMPERATURE_STEP;
+        return OK;
+    }
+    return NO_INIT;
+}
+
+int32_t LiveDisplay::getColorTemperature() {
+    int32_t kelvin = mColorTemperatureShadow.read();
+    if (kelvin >= 0) {
+        return kelvin;
+    }
+
     Mutex::Autolock _l(mLock);
 
-    if (check(Feature::COLOR_TEMPERATURE)) {
-        return mBackend->getColorBalance();
+    if (check(Feature::COLOR_TEMPERATURE) && mColorTemperature.isValid()) {
+        if (mDeferred.has(Feature::COLOR_TEMPERATURE)) {
+            return toColorTemperature(mDeferred.colorBalance);
+        }
+        if (fetchColorBalance(mCurrent.colorBalance) == OK) {
+            mCurrent.features |= Feature::COLOR_TEMPERATURE;
+            publishCurrent();
+            return toColorTemperature(mCurrent.colorBalance);
+        }
     }
+    return -1;
+}
 
-    return 0;
+status_t LiveDisplay::fetchColorBalance(int32_t& balance) {
+    return fetch(balance, [=](int32_t& out) {
+        out = mBackend->getColorBalance();
+        return OK;
+    });
 }
 
-status_t LiveDisplay::setColorBalance(int value) {
+int32_t LiveDisplay::toColorTemperature(int32_t balance) {
+    // Several temperatures share a balance value on narrow ranges,
+    // so prefer the last one requested if it still applies.
+    if (mColorTemperature.toBalance(mColorTemperatureKelvin) == balance) {
+        return mColorTemperatureKelvin;
+    }
+    return mColorTemperature.toKelvin(balance);
+}
+
+status_t LiveDisplay::setColorTemperature(int32_t kelvin) {
     status_t rc = NO_INIT;
     Mutex::Autolock _l(mLock);
 
-    if (check(Feature::COLOR_TEMPERATURE)) {
-        rc = mBackend->setColorBalance(value);
-        if (rc != OK) {
-            error("Unable to set color balance!");
+    if (check(Feature::COLOR_TEMPERATURE) && mColorTemperature.isValid()) {
+        int32_t balance = mColorTemperature.toBalance(kelvin);
+        // Set first, so the shadow published below reports this temperature
+        mColorTemperatureKelvin =
+            std::min(std::max(kelvin, COLOR_TEMPERATURE_MIN), COLOR_TEMPERATURE_MAX);
+        DisplayState change;
+        change.features = Feature::COLOR_TEMPERATURE;
+        change.colorBalance = balance;
+        if (isLayered(change) || deferWhileOff(change)) {
+            rc = OK;
+        } else {
+            rc = invoke([=] { return mBackend->setColorBalance(balance); });
+            if (rc != OK) {
+                error(rc, "Unable to set color temperature!");
+                return rc;
+            }
+            mCurrent.colorBalance = balance;
+            mCurrent.features |= Feature::COLOR_TEMPERATURE;
+            publishCurrent();
         }
+        mState.colorBalance = balance;
+        mState.features |= Feature::COLOR_TEMPERATURE;
+        saveState();
     }
     return rc;
 }
 
 bool LiveDisplay::isOutdoorModeEnabled() {
+    DisplayState current = mCurrentShadow.read();
+    if (current.has(Feature::OUTDOOR_MODE)) {
+        return current.outdoorMode;
+    }
+
     Mutex::Autolock _l(mLock);
 
-    if (check(Feature::OUTDOOR_MODE)) {
-        return mBackend->isOutdoorModeEnabled();
+    if (check(Feature::OUTDOOR_MODE) &&
+            fetch(mCurrent.outdoorMode, [=](bool& out) {
+                out = mBackend->isOutdoorModeEnabled();
+                return OK;
+            }) == OK) {
+        mCurrent.features |= Feature::OUTDOOR_MODE;
+        publishCurrent();
+        return mCurrent.outdoorMode;
     }
     return false;
 }
@@ -200,19 +1104,44 @@ status_t LiveDisplay::setOutdoorModeEnabled(bool enabled) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::OUTDOOR_MODE)) {
-        rc = mBackend->setOutdoorModeEnabled(enabled);
-        if (rc != OK) {
-            error("Unable to toggle outdoor mode!");
+        DisplayState change;
+        change.features = Feature::OUTDOOR_MODE;
+        change.outdoorMode = enabled;
+        if (isLayered(change) || deferWhileOff(change)) {
+            rc = OK;
+        } else {
+            rc = invoke([=] { return mBackend->setOutdoorModeEnabled(enabled); });
+            if (rc != OK) {
+                error(rc, "Unable to toggle outdoor mode!");
+                return rc;
+            }
+            mCurrent.outdoorMode = enabled;
+            mCurrent.features |= Feature::OUTDOOR_MODE;
+            publishCurrent();
         }
+        mState.outdoorMode = enabled;
+        mState.features |= Feature::OUTDOOR_MODE;
+        saveState();
     }
     return rc;
 }
 
 bool LiveDisplay::isAdaptiveBacklightEnabled() {
+    DisplayState current = mCurrentShadow.read();
+    if (current.has(Feature::ADAPTIVE_BACKLIGHT)) {
+        return current.adaptiveBacklight;
+    }
+
     Mutex::Autolock _l(mLock);
 
-    if (check(Feature::ADAPTIVE_BACKLIGHT)) {
-        return mBackend->isAdaptiveBacklightEnabled();
+    if (check(Feature::ADAPTIVE_BACKLIGHT) &&
+            fetch(mCurrent.adaptiveBacklight, [=](bool& out) {
+                out = mBackend->isAdaptiveBacklightEnabled();
+                return OK;
+            }) == OK) {
+        mCurrent.features |= Feature::ADAPTIVE_BACKLIGHT;
+        publishCurrent();
+        return mCurrent.adaptiveBacklight;
     }
     return false;
 }
@@ -222,10 +1151,24 @@ status_t LiveDisplay::setAdaptiveBacklightEnabled(bool enabled) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::ADAPTIVE_BACKLIGHT)) {
-        rc = mBackend->setAdaptiveBacklightEnabled(enabled);
-        if (rc != OK) {
-            error("Unable to set adaptive backlight state!");
+        DisplayState change;
+        change.features = Feature::ADAPTIVE_BACKLIGHT;
+        change.adaptiveBacklight = enabled;
+        if (isLayered(change) || deferWhileOff(change)) {
+            rc = OK;
+        } else {
+            rc = invoke([=] { return mBackend->setAdaptiveBacklightEnabled(enabled); });
+            if (rc != OK) {
+                error(rc, "Unable to set adaptive backlight state!");
+                return rc;
+            }
+            mCurrent.adaptiveBacklight = enabled;
+            mCurrent.features |= Feature::ADAPTIVE_BACKLIGHT;
+            publishCurrent();
         }
+        mState.adaptiveBacklight = enabled;
+        mState.features |= Feature::ADAPTIVE_BACKLIGHT;
+        saveState();
     }
     return rc;
 }
@@ -235,9 +1178,9 @@ status_t LiveDisplay::getPictureAdjustment(HSIC& hsic) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::PICTURE_ADJUSTMENT)) {
-        rc = mBackend->setPictureAdjustment(hsic);
+        rc = fetch(hsic, [=](HSIC& out) { return mBackend->getPictureAdjustment(out); });
         if (rc != OK) {
-            error("Unable to get picture adjustment!");
+            error(rc, "Unable to get picture adjustment!");
         }
     }
     return rc;
@@ -248,9 +1191,9 @@ status_t LiveDisplay::getDefaultPictureAdjustment(HSIC& hsic) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::PICTURE_ADJUSTMENT)) {
-        rc = mBackend->getDefaultPictureAdjustment(hsic);
+        rc = fetch(hsic, [=](HSIC& out) { return mBackend->getDefaultPictureAdjustment(out); });
         if (rc != OK) {
-            error("Unable to get default picture adjustment!");
+            error(rc, "Unable to get default picture adjustment!");
         }
     }
     return rc;
@@ -262,24 +1205,34 @@ status_t LiveDisplay::setPictureAdjustment(HSIC hsic) {
     Mutex::Autolock _l(mLock);
 
     if (check(Feature::PICTURE_ADJUSTMENT)) {
-        rc = mBackend->setPictureAdjustment(hsic);
-        if (rc != OK) {
-            error("Unable to set picture adjustment!");
+        DisplayState change;
+        change.features = Feature::PICTURE_ADJUSTMENT;
+        change.pictureAdjustment = hsic;
+        if (isLayered(change) || deferWhileOff(change)) {
+            rc = OK;
+        } else {
+            rc = invoke([=] { return mBackend->setPictureAdjustment(hsic); });
+            if (rc != OK) {
+                error(rc, "Unable to set picture adjustment!");
+                return rc;
+            }
+            mCurrent.pictureAdjustment = hsic;
+            mCurrent.features |= Feature::PICTURE_ADJUSTMENT;
+            publishCurrent();
         }
+        mState.pictureAdjustment = hsic;
+        mState.features |= Feature::PICTURE_ADJUSTMENT;
+        saveState();
     }
     return rc;
 }
 
 status_t LiveDisplay::getPictureAdjustmentRanges(HSICRanges& ranges) {
-    status_t rc = NO_INIT;
-    Mutex::Autolock _l(mLock);
-
-    if (check(Feature::PICTURE_ADJUSTMENT)) {
-        rc = mBackend->getPictureAdjustmentRanges(ranges);
-        if (rc != OK) {
-            error("Unable to get picture adjustment ranges!");
-        }
+    Capabilities caps;
+    if (getCapabilities(caps) && (caps.ranges & Feature::PICTURE_ADJUSTMENT)) {
+        ranges = caps.pictureAdjustment;
+        return OK;
     }
-    return rc;
+    return NO_INIT;
 }
 };
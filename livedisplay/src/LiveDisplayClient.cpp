@@ -0,0 +1,311 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Client"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <cutils/sockets.h>
+#include <utils/Log.h>
+
+#include "LiveDisplayClient.h"
+
+namespace android {
+
+size_t LiveDisplayBatch::add(uint32_t op, int32_t value) {
+    ld_request req;
+    memset(&req, 0, sizeof(req));
+    req.op = op;
+    req.value = value;
+    mRequests.push_back(req);
+    return mRequests.size() - 1;
+}
+
+size_t LiveDisplayBatch::setDisplayMode(int32_t modeID, bool makeDefault) {
+    size_t i = add(OP_SET_DISPLAY_MODE);
+    mRequests[i].mode.id = modeID;
+    mRequests[i].mode.makeDefault = makeDefault;
+    return i;
+}
+
+size_t LiveDisplayBatch::setPictureAdjustment(const HSIC& hsic) {
+    size_t i = add(OP_SET_PICTURE_ADJUSTMENT);
+    LiveDisplayProtocol::toWire(hsic, mRequests[i].hsic);
+    return i;
+}
+
+void LiveDisplayBatch::clear() {
+    mRequests.clear();
+    mResponses.clear();
+    mRecords.clear();
+}
+
+static sp<DisplayMode> fromRecord(const DisplayModeRecord& r) {
+    sp<DisplayMode> mode = new DisplayMode(r.id, r.name, strnlen(r.name, DISPLAY_MODE_NAME_MAX));
+    mode->privFlags = r.privFlags;
+    return mode;
+}
+
+void LiveDisplayBatch::getDisplayModes(size_t i, List<sp<DisplayMode>>& modes) const {
+    const ld_response& resp = mResponses[i];
+    if (resp.op != OP_GET_DISPLAY_MODES || resp.status != OK) {
+        return;
+    }
+    for (uint32_t j = resp.modes.first;
+            j < resp.modes.first + resp.modes.count && j < mRecords.size(); j++) {
+        modes.push_back(fromRecord(mRecords[j]));
+    }
+}
+
+//----------------------------------------------------------------------------/
+
+LiveDisplayClient::LiveDisplayClient() : mFd(-1), mOwned(true) {
+}
+
+LiveDisplayClient::LiveDisplayClient(int fd) : mFd(fd), mOwned(false) {
+}
+
+LiveDisplayClient::~LiveDisplayClient() {
+    closeSocket();
+}
+
+void LiveDisplayClient::disconnect() {
+    Mutex::Autolock _l(mLock);
+    closeSocket();
+}
+
+void LiveDisplayClient::closeSocket() {
+    if (mOwned && mFd >= 0) {
+        close(mFd);
+        mFd = -1;
+    }
+}
+
+status_t LiveDisplayClient::execute(LiveDisplayBatch& batch) {
+    if (batch.mRequests.size() > LIVEDISPLAY_MAX_BATCH) {
+        return BAD_VALUE;
+    }
+    Mutex::Autolock _l(mLock);
+    return transact(batch);
+}
+
+status_t LiveDisplayClient::transact(LiveDisplayBatch& batch) {
+    uint32_t count = batch.mRequests.size();
+    batch.mResponses.resize(count);
+    batch.mRecords.clear();
+
+    if (mFd < 0 && mOwned) {
+        mFd = socket_local_client(LIVEDISPLAY_SOCKET, ANDROID_SOCKET_NAMESPACE_RESERVED,
+                                  SOCK_STREAM);
+        if (mFd < 0) {
+            ALOGE("Unable to connect to livedisplayd");
+            return NO_INIT;
+        }
+    }
+    if (mFd < 0) {
+        return DEAD_OBJECT;
+    }
+
+    status_t rc = LiveDisplayProtocol::writeFrame(mFd, batch.mRequests.data(), count,
+                                                  sizeof(ld_request));
+    ld_header header;
+    if (rc == OK) {
+        rc = LiveDisplayProtocol::readHeader(mFd, header, count);
+    }
+    if (rc == OK && header.count != count) {
+        rc = BAD_VALUE;
+    }
+    if (rc == OK) {
+        rc = LiveDisplayProtocol::readFully(mFd, batch.mResponses.data(),
+                                            count * sizeof(ld_response));
+    }
+    if (rc == OK && header.records > 0) {
+        batch.mRecords.resize(header.records);
+        rc = LiveDisplayProtocol::readFully(mFd, batch.mRecords.data(),
+                                            header.records * sizeof(DisplayModeRecord));
+    }
+    if (rc != OK) {
+        ALOGE("Request to livedisplayd failed: %d", rc);
+        closeSocket();
+    }
+    return rc;
+}
+
+status_t LiveDisplayClient::call(uint32_t op, int32_t value, ld_response& resp) {
+    LiveDisplayBatch batch;
+    batch.add(op, value);
+
+    status_t rc = execute(batch);
+    if (rc != OK) {
+        return rc;
+    }
+    resp = batch.response(0);
+    return resp.status;
+}
+
+uint32_t LiveDisplayClient::getSupportedFeatures() {
+    ld_response resp;
+    return call(OP_GET_SUPPORTED_FEATURES, 0, resp) == OK ? resp.value : 0;
+}
+
+status_t LiveDisplayClient::setAdaptiveBacklightEnabled(bool enabled) {
+    ld_response resp;
+    return call(OP_SET_ADAPTIVE_BACKLIGHT, enabled, resp);
+}
+
+bool LiveDisplayClient::isAdaptiveBacklightEnabled() {
+    ld_response resp;
+    return call(OP_IS_ADAPTIVE_BACKLIGHT, 0, resp) == OK && resp.value != 0;
+}
+
+status_t LiveDisplayClient::setOutdoorModeEnabled(bool enabled) {
+    ld_response resp;
+    return call(OP_SET_OUTDOOR_MODE, enabled, resp);
+}
+
+bool LiveDisplayClient::isOutdoorModeEnabled() {
+    ld_response resp;
+    return call(OP_IS_OUTDOOR_MODE, 0, resp) == OK && resp.value != 0;
+}
+
+static void fromWire(const ld_range& range, Range& out) {
+    out.min = range.min;
+    out.max = range.max;
+    out.step = range.step;
+}
+
+static void fromWire(const ld_float_range& range, FloatRange& out) {
+    out.min = range.min;
+    out.max = range.max;
+    out.step = range.step;
+}
+
+status_t LiveDisplayClient::getColorBalanceRange(Range& range) {
+    ld_response resp;
+    status_t rc = call(OP_GET_COLOR_BALANCE_RANGE, 0, resp);
+    if (rc == OK) {
+        fromWire(resp.range, range);
+    }
+    return rc;
+}
+
+status_t LiveDisplayClient::setColorBalance(int32_t balance) {
+    ld_response resp;
+    return call(OP_SET_COLOR_BALANCE, balance, resp);
+}
+
+int32_t LiveDisplayClient::getColorBalance() {
+    ld_response resp;
+    return call(OP_GET_COLOR_BALANCE, 0, resp) == OK ? resp.value : 0;
+}
+
+status_t LiveDisplayClient::getColorTemperatureRange(Range& range) {
+    ld_response resp;
+    status_t rc = call(OP_GET_COLOR_TEMPERATURE_RANGE, 0, resp);
+    if (rc == OK) {
+        fromWire(resp.range, range);
+    }
+    return rc;
+}
+
+status_t LiveDisplayClient::setColorTemperature(int32_t kelvin) {
+    ld_response resp;
+    return call(OP_SET_COLOR_TEMPERATURE, kelvin, resp);
+}
+
+int32_t LiveDisplayClient::getColorTemperature() {
+    ld_response resp;
+    return call(OP_GET_COLOR_TEMPERATURE, 0, resp) == OK ? resp.value : -1;
+}
+
+status_t LiveDisplayClient::getDisplayModes(List<sp<DisplayMode>>& profiles) {
+    LiveDisplayBatch batch;
+    batch.add(OP_GET_DISPLAY_MODES);
+
+    status_t rc = execute(batch);
+    if (rc != OK) {
+        return rc;
+    }
+    batch.getDisplayModes(0, profiles);
+    return batch.status(0);
+}
+
+status_t LiveDisplayClient::setDisplayMode(int32_t modeID, bool makeDefault) {
+    LiveDisplayBatch batch;
+    batch.setDisplayMode(modeID, makeDefault);
+
+    status_t rc = execute(batch);
+    return rc != OK ? rc : batch.status(0);
+}
+
+sp<DisplayMode> LiveDisplayClient::getMode(uint32_t op) {
+    ld_response resp;
+    if (call(op, 0, resp) != OK) {
+        return nullptr;
+    }
+    resp.mode.name[DISPLAY_MODE_NAME_MAX - 1] = '\0';
+    return fromRecord(resp.mode);
+}
+
+sp<DisplayMode> LiveDisplayClient::getCurrentDisplayMode() {
+    return getMode(OP_GET_CURRENT_DISPLAY_MODE);
+}
+
+sp<DisplayMode> LiveDisplayClient::getDefaultDisplayMode() {
+    return getMode(OP_GET_DEFAULT_DISPLAY_MODE);
+}
+
+status_t LiveDisplayClient::getPictureAdjustmentRanges(HSICRanges& ranges) {
+    ld_response resp;
+    status_t rc = call(OP_GET_PICTURE_ADJUSTMENT_RANGES, 0, resp);
+    if (rc == OK) {
+        fromWire(resp.ranges.hue, ranges.hue);
+        fromWire(resp.ranges.saturation, ranges.saturation);
+        fromWire(resp.ranges.intensity, ranges.intensity);
+        fromWire(resp.ranges.contrast, ranges.contrast);
+        fromWire(resp.ranges.saturationThreshold, ranges.saturationThreshold);
+    }
+    return rc;
+}
+
+status_t LiveDisplayClient::getPictureAdjustment(HSIC& hsic) {
+    ld_response resp;
+    status_t rc = call(OP_GET_PICTURE_ADJUSTMENT, 0, resp);
+    if (rc == OK) {
+        hsic = LiveDisplayProtocol::fromWire(resp.hsic);
+    }
+    return rc;
+}
+
+status_t LiveDisplayClient::getDefaultPictureAdjustment(HSIC& hsic) {
+    ld_response resp;
+    status_t rc = call(OP_GET_DEFAULT_PICTURE_ADJUSTMENT, 0, resp);
+    if (rc == OK) {
+        hsic = LiveDisplayProtocol::fromWire(resp.hsic);
+    }
+    return rc;
+}
+
+status_t LiveDisplayClient::setPictureAdjustment(HSIC hsic) {
+    LiveDisplayBatch batch;
+    batch.setPictureAdjustment(hsic);
+
+    status_t rc = execute(batch);
+    return rc != OK ? rc : batch.status(0);
+}
+};
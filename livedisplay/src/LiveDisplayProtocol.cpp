@@ -0,0 +1,102 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "LiveDisplayProtocol.h"
+
+namespace android {
+
+status_t LiveDisplayProtocol::writeFrame(int fd, const void* entries, uint32_t count,
+                                         size_t size, const DisplayModeRecord* records,
+                                         uint32_t nrecords) {
+    ld_header header;
+    header.magic = LIVEDISPLAY_PROTOCOL_MAGIC;
+    header.version = LIVEDISPLAY_PROTOCOL_VERSION;
+    header.count = count;
+    header.records = nrecords;
+
+    // Assembled up front so a whole batch goes out in a single send
+    std::vector<uint8_t> buf(sizeof(header) + count * size + nrecords * sizeof(*records));
+    uint8_t* p = buf.data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    if (count > 0) {
+        memcpy(p, entries, count * size);
+        p += count * size;
+    }
+    if (nrecords > 0) {
+        memcpy(p, records, nrecords * sizeof(*records));
+    }
+
+    p = buf.data();
+    size_t len = buf.size();
+    while (len > 0) {
+        ssize_t ret = TEMP_FAILURE_RETRY(send(fd, p, len, MSG_NOSIGNAL));
+        if (ret <= 0) {
+            return ret < 0 ? -errno : UNKNOWN_ERROR;
+        }
+        p += ret;
+        len -= ret;
+    }
+    return OK;
+}
+
+status_t LiveDisplayProtocol::readFully(int fd, void* data, size_t len) {
+    uint8_t* p = (uint8_t*)data;
+    while (len > 0) {
+        ssize_t ret = TEMP_FAILURE_RETRY(recv(fd, p, len, MSG_WAITALL));
+        if (ret <= 0) {
+            return ret < 0 ? -errno : DEAD_OBJECT;
+        }
+        p += ret;
+        len -= ret;
+    }
+    return OK;
+}
+
+status_t LiveDisplayProtocol::readHeader(int fd, ld_header& header, uint32_t max) {
+    status_t rc = readFully(fd, &header, sizeof(header));
+    if (rc != OK) {
+        return rc;
+    }
+    if (header.magic != LIVEDISPLAY_PROTOCOL_MAGIC ||
+            header.version != LIVEDISPLAY_PROTOCOL_VERSION || header.count > max ||
+            header.records > LIVEDISPLAY_MAX_RECORDS) {
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
+void LiveDisplayProtocol::toWire(const HSIC& hsic, ld_hsic& out) {
+    out.hue = hsic.hue;
+    out.saturation = hsic.saturation;
+    out.intensity = hsic.intensity;
+    out.contrast = hsic.contrast;
+    out.saturationThreshold = hsic.saturationThreshold;
+}
+
+HSIC LiveDisplayProtocol::fromWire(const ld_hsic& hsic) {
+    return HSIC(hsic.hue, hsic.saturation, hsic.intensity, hsic.contrast,
+                hsic.saturationThreshold);
+}
+};
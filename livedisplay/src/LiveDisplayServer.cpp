@@ -0,0 +1,280 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#define LOG_TAG "LiveDisplay-Server"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <private/android_filesystem_config.h>
+#include <utils/Log.h>
+
+#include "LiveDisplayServer.h"
+
+namespace android {
+
+static void toRecord(const sp<DisplayMode>& mode, DisplayModeRecord& r) {
+    memset(&r, 0, sizeof(r));
+    r.id = mode->id;
+    r.privFlags = mode->privFlags;
+    strncpy(r.name, mode->name.string(), DISPLAY_MODE_NAME_MAX - 1);
+}
+
+static void toWire(const Range& range, ld_range& out) {
+    out.min = range.min;
+    out.max = range.max;
+    out.step = range.step;
+}
+
+static void toWire(const FloatRange& range, ld_float_range& out) {
+    out.min = range.min;
+    out.max = range.max;
+    out.step = range.step;
+}
+
+static bool isTrusted(int fd) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        ALOGE("Unable to identify client: %s", strerror(errno));
+        return false;
+    }
+    if (cred.uid != AID_SYSTEM && cred.uid != AID_ROOT) {
+        ALOGW("Refusing client pid %d uid %d", cred.pid, cred.uid);
+        return false;
+    }
+    return true;
+}
+
+status_t LiveDisplayServer::run(int listenFd) {
+    struct pollfd fds[LIVEDISPLAY_MAX_CLIENTS + 1];
+    nfds_t count = 1;
+    fds[0].fd = listenFd;
+    fds[0].events = POLLIN;
+
+    while (true) {
+        if (TEMP_FAILURE_RETRY(poll(fds, count, -1)) < 0) {
+            ALOGE("poll failed: %s", strerror(errno));
+            return -errno;
+        }
+
+        // Backwards, as a client which hung up is replaced by the last one
+        for (nfds_t i = count - 1; i > 0; i--) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & POLLIN) && serveFrame(fds[i].fd) == OK) {
+                continue;
+            }
+            close(fds[i].fd);
+            fds[i] = fds[--count];
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        int fd = TEMP_FAILURE_RETRY(accept4(listenFd, NULL, NULL, SOCK_CLOEXEC));
+        if (fd < 0) {
+            if (errno == ECONNABORTED || errno == EAGAIN) {
+                continue;
+            }
+            ALOGE("accept failed: %s", strerror(errno));
+            return -errno;
+        }
+        if (count > LIVEDISPLAY_MAX_CLIENTS) {
+            ALOGW("Too many clients, refusing another");
+            close(fd);
+            continue;
+        }
+        if (!isTrusted(fd)) {
+            close(fd);
+            continue;
+        }
+
+        struct timeval timeout;
+        timeout.tv_sec = LIVEDISPLAY_CLIENT_TIMEOUT_MS / 1000;
+        timeout.tv_usec = (LIVEDISPLAY_CLIENT_TIMEOUT_MS % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        fds[count].fd = fd;
+        fds[count].events = POLLIN;
+        fds[count].revents = 0;
+        count++;
+    }
+}
+
+status_t LiveDisplayServer::serve(int fd) {
+    status_t rc;
+    do {
+        rc = serveFrame(fd);
+    } while (rc == OK);
+    return rc;
+}
+
+status_t LiveDisplayServer::serveFrame(int fd) {
+    ld_header header;
+    status_t rc = LiveDisplayProtocol::readHeader(fd, header, LIVEDISPLAY_MAX_BATCH);
+    if (rc == OK && header.records != 0) {
+        rc = BAD_VALUE;
+    }
+    if (rc == OK) {
+        rc = LiveDisplayProtocol::readFully(fd, mRequests, header.count * sizeof(mRequests[0]));
+    }
+    if (rc != OK) {
+        if (rc != DEAD_OBJECT) {
+            ALOGE("Dropping client after bad request: %d", rc);
+        }
+        return rc;
+    }
+
+    mRecords.clear();
+    for (uint32_t i = 0; i < header.count; i++) {
+        dispatch(mRequests[i], mResponses[i], mRecords);
+    }
+
+    return LiveDisplayProtocol::writeFrame(fd, mResponses, header.count, sizeof(mResponses[0]),
+                                           mRecords.data(), mRecords.size());
+}
+
+status_t LiveDisplayServer::initialize() {
+    if (mInitialized) {
+        return OK;
+    }
+    status_t rc = mBackend.initialize();
+    if (rc != OK) {
+        ALOGE("Failed to initialize backend: %d", rc);
+        return rc;
+    }
+    mInitialized = true;
+    mFeatures = mBackend.getSupportedFeatures();
+    ALOGD("Backend up with features 0x%x", mFeatures);
+    return OK;
+}
+
+void LiveDisplayServer::dispatch(const ld_request& req, ld_response& resp,
+                                 std::vector<DisplayModeRecord>& records) {
+    memset(&resp, 0, sizeof(resp));
+    resp.op = req.op;
+
+    // Nothing reaches a backend which isn't up
+    resp.status = initialize();
+    if (resp.status != OK) {
+        return;
+    }
+
+    switch (req.op) {
+        case OP_INITIALIZE:
+        case OP_GET_SUPPORTED_FEATURES:
+            resp.value = mFeatures;
+            break;
+        case OP_SET_ADAPTIVE_BACKLIGHT:
+            resp.status = mBackend.setAdaptiveBacklightEnabled(req.value != 0);
+            break;
+        case OP_IS_ADAPTIVE_BACKLIGHT:
+            resp.value = mBackend.isAdaptiveBacklightEnabled();
+            break;
+        case OP_SET_OUTDOOR_MODE:
+            resp.status = mBackend.setOutdoorModeEnabled(req.value != 0);
+            break;
+        case OP_IS_OUTDOOR_MODE:
+            resp.value = mBackend.isOutdoorModeEnabled();
+            break;
+        case OP_GET_COLOR_BALANCE_RANGE: {
+            Range range;
+            resp.status = mBackend.getColorBalanceRange(range);
+            toWire(range, resp.range);
+            break;
+        }
+        case OP_SET_COLOR_BALANCE:
+            resp.status = mBackend.setColorBalance(req.value);
+            break;
+        case OP_GET_COLOR_BALANCE:
+            resp.value = mBackend.getColorBalance();
+            break;
+        case OP_GET_COLOR_TEMPERATURE_RANGE: {
+            Range range;
+            resp.status = mBackend.getColorTemperatureRange(range);
+            toWire(range, resp.range);
+            break;
+        }
+        case OP_SET_COLOR_TEMPERATURE:
+            resp.status = mBackend.setColorTemperature(req.value);
+            break;
+        case OP_GET_COLOR_TEMPERATURE:
+            resp.value = mBackend.getColorTemperature();
+            break;
+        case OP_GET_DISPLAY_MODES: {
+            List<sp<DisplayMode>> modes;
+            resp.status = mBackend.getDisplayModes(modes);
+            resp.modes.first = records.size();
+            for (List<sp<DisplayMode>>::iterator it = modes.begin();
+                    it != modes.end() && records.size() < LIVEDISPLAY_MAX_RECORDS; ++it) {
+                DisplayModeRecord r;
+                toRecord(*it, r);
+                records.push_back(r);
+            }
+            resp.modes.count = records.size() - resp.modes.first;
+            break;
+        }
+        case OP_SET_DISPLAY_MODE:
+            resp.status = mBackend.setDisplayMode(req.mode.id, req.mode.makeDefault != 0);
+            break;
+        case OP_GET_CURRENT_DISPLAY_MODE:
+        case OP_GET_DEFAULT_DISPLAY_MODE: {
+            sp<DisplayMode> mode = req.op == OP_GET_CURRENT_DISPLAY_MODE
+                                           ? mBackend.getCurrentDisplayMode()
+                                           : mBackend.getDefaultDisplayMode();
+            if (mode == NULL) {
+                resp.status = NAME_NOT_FOUND;
+            } else {
+                toRecord(mode, resp.mode);
+            }
+            break;
+        }
+        case OP_GET_PICTURE_ADJUSTMENT_RANGES: {
+            HSICRanges ranges;
+            resp.status = mBackend.getPictureAdjustmentRanges(ranges);
+            toWire(ranges.hue, resp.ranges.hue);
+            toWire(ranges.saturation, resp.ranges.saturation);
+            toWire(ranges.intensity, resp.ranges.intensity);
+            toWire(ranges.contrast, resp.ranges.contrast);
+            toWire(ranges.saturationThreshold, resp.ranges.saturationThreshold);
+            break;
+        }
+        case OP_GET_PICTURE_ADJUSTMENT:
+        case OP_GET_DEFAULT_PICTURE_ADJUSTMENT: {
+            HSIC hsic;
+            resp.status = req.op == OP_GET_PICTURE_ADJUSTMENT
+                                  ? mBackend.getPictureAdjustment(hsic)
+                                  : mBackend.getDefaultPictureAdjustment(hsic);
+            LiveDisplayProtocol::toWire(hsic, resp.hsic);
+            break;
+        }
+        case OP_SET_PICTURE_ADJUSTMENT:
+            resp.status = mBackend.setPictureAdjustment(LiveDisplayProtocol::fromWire(req.hsic));
+            break;
+        default:
+            resp.status = INVALID_OPERATION;
+            break;
+    }
+}
+};
@@ -0,0 +1,44 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include "ProfileStore.h"
+
+namespace android {
+
+void ProfileStore::put(int32_t id, const DisplayState& state) {
+    mProfiles.replaceValueFor(id, state);
+}
+
+status_t ProfileStore::remove(int32_t id) {
+    if (mProfiles.removeItem(id) < 0) {
+        return NAME_NOT_FOUND;
+    }
+    return OK;
+}
+
+void ProfileStore::clear() {
+    mProfiles.clear();
+}
+
+status_t ProfileStore::get(int32_t id, DisplayState& state) const {
+    ssize_t idx = mProfiles.indexOfKey(id);
+    if (idx < 0) {
+        return NAME_NOT_FOUND;
+    }
+    state = mProfiles.valueAt(idx);
+    return OK;
+}
+};
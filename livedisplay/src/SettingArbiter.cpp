@@ -0,0 +1,121 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <algorithm>
+#include <vector>
+
+#include "SettingArbiter.h"
+
+namespace android {
+
+bool SettingArbiter::setBase(const DisplayState& base) {
+    mBase = base;
+    return resolve();
+}
+
+bool SettingArbiter::set(int32_t client, int32_t priority, const DisplayState& state) {
+    Layer layer;
+    layer.priority = priority;
+    layer.state = state;
+    mLayers.replaceValueFor(client, layer);
+
+    ssize_t idx = mStats.indexOfKey(client);
+    if (idx < 0) {
+        idx = mStats.add(client, ClientStats());
+    }
+    mStats.editValueAt(idx).requests++;
+
+    bool changed = resolve();
+    if (changed) {
+        mStats.editValueAt(mStats.indexOfKey(client)).changes++;
+    }
+    return changed;
+}
+
+bool SettingArbiter::remove(int32_t client) {
+    if (mLayers.removeItem(client) < 0) {
+        return false;
+    }
+    mStats.removeItem(client);
+    return resolve();
+}
+
+uint32_t SettingArbiter::features(int32_t client) const {
+    ssize_t idx = mLayers.indexOfKey(client);
+    return idx < 0 ? 0 : mLayers.valueAt(idx).state.features;
+}
+
+void SettingArbiter::recordOps(int32_t client, uint32_t ops) {
+    ssize_t idx = mStats.indexOfKey(client);
+    if (idx >= 0) {
+        mStats.editValueAt(idx).ops += ops;
+    }
+}
+
+status_t SettingArbiter::getStats(int32_t client, ClientStats& stats) const {
+    ssize_t idx = mStats.indexOfKey(client);
+    if (idx < 0) {
+        return NAME_NOT_FOUND;
+    }
+    stats = mStats.valueAt(idx);
+    return OK;
+}
+
+bool SettingArbiter::resolve() {
+    // Lowest priority first, ties broken by client id to stay stable
+    std::vector<size_t> order(mLayers.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        const Layer& la = mLayers.valueAt(a);
+        const Layer& lb = mLayers.valueAt(b);
+        if (la.priority != lb.priority) {
+            return la.priority < lb.priority;
+        }
+        return mLayers.keyAt(a) < mLayers.keyAt(b);
+    });
+
+    DisplayState resolved = mBase;
+    for (size_t i = 0; i < order.size(); i++) {
+        resolved.merge(mLayers.valueAt(order[i]).state);
+    }
+
+    // Work out which layer won each setting, top down
+    uint32_t taken = 0;
+    for (size_t i = order.size(); i-- > 0;) {
+        int32_t client = mLayers.keyAt(order[i]);
+        uint32_t features = mLayers.valueAt(order[i]).state.features & ~taken;
+        taken |= features;
+        if (features & Feature::DISPLAY_MODES) {
+            // Lower layers' picture adjustment goes with the old mode
+            taken |= Feature::PICTURE_ADJUSTMENT;
+        }
+
+        ssize_t idx = mStats.indexOfKey(client);
+        if (idx >= 0) {
+            mStats.editValueAt(idx).owned = features;
+        }
+    }
+
+    mLayered = taken;
+
+    bool changed = resolved != mResolved;
+    mResolved = resolved;
+    return changed;
+}
+};
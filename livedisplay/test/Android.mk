@@ -7,3 +7,103 @@ LOCAL_SHARED_LIBRARIES := libcutils
 LOCAL_SRC_FILES := pp_client.c
 include $(BUILD_EXECUTABLE)
 
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_gamma_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_SHARED_LIBRARIES := libcutils liblog libutils
+LOCAL_STATIC_LIBRARIES := liblivedisplay
+LOCAL_SRC_FILES := gamma_bench.cpp
+LOCAL_CFLAGS := -std=c++11
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_pipeline_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_SHARED_LIBRARIES := libcutils liblog libutils
+LOCAL_STATIC_LIBRARIES := liblivedisplay
+LOCAL_SRC_FILES := pipeline_bench.cpp
+LOCAL_CFLAGS := -std=c++11
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_modes_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_SHARED_LIBRARIES := libcutils liblog libutils
+LOCAL_STATIC_LIBRARIES := liblivedisplay liblivedisplay_client
+LOCAL_SRC_FILES := modes_bench.cpp
+LOCAL_CFLAGS := -std=c++11
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_probe_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_SHARED_LIBRARIES := libcutils liblog libutils
+LOCAL_STATIC_LIBRARIES := liblivedisplay
+LOCAL_SRC_FILES := probe_bench.cpp
+LOCAL_CFLAGS := -std=c++11
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_bind_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_SHARED_LIBRARIES := libcutils libdl liblog libutils
+LOCAL_STATIC_LIBRARIES := liblivedisplay
+LOCAL_SRC_FILES := bind_bench.cpp
+LOCAL_CFLAGS := -std=c++11
+include $(BUILD_EXECUTABLE)
+
+# Records the device dump used by livedisplay_golden_test
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_vendor_sweep
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_SHARED_LIBRARIES := libcutils liblog libutils
+LOCAL_STATIC_LIBRARIES := liblivedisplay
+LOCAL_SRC_FILES := vendor_sweep.cpp ColorDiff.cpp
+LOCAL_CFLAGS := -std=c++11
+include $(BUILD_EXECUTABLE)
+
+# Run on the host, serves FakeBackend over socketpairs
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_client_server_test
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_STATIC_LIBRARIES := libcutils libutils liblog
+LOCAL_SRC_FILES := \
+    client_server_test.cpp \
+    ../src/LiveDisplayClient.cpp \
+    ../src/LiveDisplayServer.cpp \
+    ../src/LiveDisplayProtocol.cpp \
+    ../impl/RemoteBackend.cpp
+LOCAL_CFLAGS := -std=c++11
+LOCAL_LDLIBS := -lpthread
+include $(BUILD_HOST_EXECUTABLE)
+
+# Run on the host against goldens/color_sweep.golden and a device dump
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_golden_test
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../impl $(LOCAL_PATH)/../inc
+LOCAL_STATIC_LIBRARIES := libutils liblog
+LOCAL_SRC_FILES := \
+    golden_test.cpp \
+    ColorDiff.cpp \
+    ../src/ColorPipeline.cpp \
+    ../src/ColorTemperature.cpp
+LOCAL_CFLAGS := -std=c++11
+LOCAL_LDLIBS := -lpthread
+include $(BUILD_HOST_EXECUTABLE)
+
+# Run on the device with app_process, see LiveDisplayJniBench.java
+include $(CLEAR_VARS)
+LOCAL_MODULE := livedisplay_jni_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_SRC_FILES := $(call all-java-files-under, java)
+LOCAL_JAVA_LIBRARIES := org.cyanogenmod.platform
+include $(BUILD_JAVA_LIBRARY)
@@ -0,0 +1,71 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAY_BENCHUTILS_H
+#define CYNGN_LIVEDISPLAY_BENCHUTILS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <functional>
+
+#include "PlatformBackend.h"
+
+namespace android {
+
+// The backend livedisplayd would use on this device, NULL if there is none
+static inline LiveDisplayBackend* createBackend() {
+    return createPlatformBackend();
+}
+
+/*
+ * Runs fn in a child process, so that every run starts with the vendor
+ * library unloaded and nothing cached. Returns false if fn failed,
+ * which it reports by returning a negative value.
+ */
+static inline bool runInChild(std::function<int64_t()> fn, int64_t& result) {
+    int fds[2];
+    if (pipe(fds) < 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        int64_t value = fn();
+        ssize_t len = write(fds[1], &value, sizeof(value));
+        _exit(len == sizeof(value) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t len = TEMP_FAILURE_RETRY(read(fds[0], &result, sizeof(result)));
+    close(fds[0]);
+
+    int status = 0;
+    TEMP_FAILURE_RETRY(waitpid(pid, &status, 0));
+    return len == sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == 0 && result >= 0;
+}
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <math.h>
+
+#include <atomic>
+#include <vector>
+
+#include "ColorDiff.h"
+#include "Parallel.h"
+
+namespace android {
+
+// sRGB transfer function, decoded once
+static const float* linearTable() {
+    static float table[256];
+    static bool initialized = [] {
+        for (int i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            table[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return true;
+    }();
+    (void)initialized;
+    return table;
+}
+
+static inline float labf(float t) {
+    return t > 0.008856f ? cbrtf(t) : 7.787f * t + 16.0f / 116.0f;
+}
+
+void ColorDiff::toLab(const uint8_t* rgb, float lab[3]) {
+    const float* lin = linearTable();
+    float r = lin[rgb[0]];
+    float g = lin[rgb[1]];
+    float b = lin[rgb[2]];
+
+    // sRGB to XYZ, normalized to the D65 white
+    float x = labf((0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f);
+    float y = labf(0.2126f * r + 0.7152f * g + 0.0722f * b);
+    float z = labf((0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f);
+
+    lab[0] = 116.0f * y - 16.0f;
+    lab[1] = 500.0f * (x - y);
+    lab[2] = 200.0f * (y - z);
+}
+
+float ColorDiff::deltaE(const uint8_t* a, const uint8_t* b) {
+    float la[3], lb[3];
+    toLab(a, la);
+    toLab(b, lb);
+
+    float dl = la[0] - lb[0];
+    float da = la[1] - lb[1];
+    float db = la[2] - lb[2];
+    return sqrtf(dl * dl + da * da + db * db);
+}
+
+status_t ColorDiff::compare(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height,
+                            uint32_t stride, float tolerance, DeltaEStats& stats,
+                            uint32_t threads) {
+    if (a == NULL || b == NULL || stride < width) {
+        return BAD_VALUE;
+    }
+
+    threads = parallelBands(height, threads);
+
+    std::vector<DeltaEStats> bands(threads);
+    std::vector<double> sums(threads, 0.0);
+
+    parallelFor(height, threads, [&](uint32_t band, uint32_t first, uint32_t last) {
+        DeltaEStats& s = bands[band];
+        for (uint32_t y = first; y < last; y++) {
+            const uint8_t* pa = a + (size_t)y * stride * 4;
+            const uint8_t* pb = b + (size_t)y * stride * 4;
+            for (uint32_t x = 0; x < width; x++, pa += 4, pb += 4) {
+                float d = deltaE(pa, pb);
+                s.max = std::max(s.max, d);
+                s.exceeded += d > tolerance;
+                sums[band] += d;
+            }
+        }
+        s.pixels = (last - first) * width;
+    });
+
+    double sum = 0.0;
+    stats = DeltaEStats();
+    for (uint32_t i = 0; i < threads; i++) {
+        stats.max = std::max(stats.max, bands[i].max);
+        stats.exceeded += bands[i].exceeded;
+        stats.pixels += bands[i].pixels;
+        sum += sums[i];
+    }
+    stats.mean = stats.pixels > 0 ? (float)(sum / stats.pixels) : 0.0f;
+    return OK;
+}
+
+//----------------------------------------------------------------------------/
+
+ColorSweep::ColorSweep(const HSICRanges& ranges, const Range& balance, uint32_t steps)
+    : mRanges(ranges), mBalance(balance), mSteps(std::max(steps, 1u)) {
+}
+
+uint64_t ColorSweep::size() const {
+    // hue, saturation, intensity, contrast, threshold and balance
+    uint64_t n = 1;
+    for (int i = 0; i < 6; i++) {
+        n *= mSteps;
+    }
+    return n;
+}
+
+static float sample(float min, float max, uint32_t step, uint32_t steps) {
+    if (steps == 1) {
+        return 0.0f;
+    }
+    return min + (max - min) * step / (steps - 1);
+}
+
+void ColorSweep::at(uint32_t index, HSIC& hsic, int32_t& balance) const {
+    uint32_t s[6];
+    for (int i = 0; i < 6; i++) {
+        s[i] = index % mSteps;
+        index /= mSteps;
+    }
+
+    hsic.hue = (int32_t)lroundf(sample(mRanges.hue.min, mRanges.hue.max, s[0], mSteps));
+    hsic.saturation = sample(mRanges.saturation.min, mRanges.saturation.max, s[1], mSteps);
+    hsic.intensity = sample(mRanges.intensity.min, mRanges.intensity.max, s[2], mSteps);
+    hsic.contrast = sample(mRanges.contrast.min, mRanges.contrast.max, s[3], mSteps);
+    hsic.saturationThreshold = sample(mRanges.saturationThreshold.min,
+                                      mRanges.saturationThreshold.max, s[4], mSteps);
+    balance = (int32_t)lroundf(sample(mBalance.min, mBalance.max, s[5], mSteps));
+}
+
+status_t ColorSweep::run(std::function<bool(uint32_t, const HSIC&, int32_t)> fn,
+                         uint32_t& failed, uint32_t threads) const {
+    if (size() > UINT32_MAX) {
+        return BAD_VALUE;
+    }
+
+    std::atomic<uint32_t> count(0);
+    parallelFor((uint32_t)size(), threads, [&](uint32_t, uint32_t first, uint32_t last) {
+        HSIC hsic;
+        int32_t balance;
+        for (uint32_t i = first; i < last; i++) {
+            at(i, hsic, balance);
+            if (!fn(i, hsic, balance)) {
+                count++;
+            }
+        }
+    });
+    failed = count;
+    return OK;
+}
+};
@@ -0,0 +1,87 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef CYNGN_LIVEDISPLAY_COLORDIFF_H
+#define CYNGN_LIVEDISPLAY_COLORDIFF_H
+
+#include <stdint.h>
+
+#include <functional>
+
+#include <utils/Errors.h>
+
+#include <Types.h>
+
+namespace android {
+
+class DeltaEStats {
+  public:
+    DeltaEStats() : max(0.0f), mean(0.0f), exceeded(0), pixels(0) {
+    }
+
+    float max;
+    float mean;
+    uint32_t exceeded;  // pixels above the tolerance
+    uint32_t pixels;
+};
+
+/*
+ * Perceptual comparison of RGBA8888 buffers, used to check rendered
+ * previews against stored goldens. Pixels are taken as sRGB with a D65
+ * white and compared in CIELAB with the CIE76 distance. Alpha is ignored.
+ */
+class ColorDiff {
+  public:
+    static void toLab(const uint8_t* rgb, float lab[3]);
+
+    static float deltaE(const uint8_t* a, const uint8_t* b);
+
+    static status_t compare(const uint8_t* a, const uint8_t* b, uint32_t width, uint32_t height,
+                            uint32_t stride, float tolerance, DeltaEStats& stats,
+                            uint32_t threads = 0);
+};
+
+/*
+ * Enumerates the cartesian product of picture adjustment and color
+ * balance settings across the ranges reported by a backend. Each axis
+ * is sampled at the given number of evenly spaced points including
+ * both ends, or at zero if only one step is requested.
+ */
+class ColorSweep {
+  public:
+    ColorSweep(const HSICRanges& ranges, const Range& balance, uint32_t steps);
+
+    // steps^6, which outgrows 32 bits from 41 steps on
+    uint64_t size() const;
+
+    void at(uint32_t index, HSIC& hsic, int32_t& balance) const;
+
+    /*
+     * Calls fn(index, hsic, balance) for every setting, split across
+     * threads, and counts the settings for which fn returned false.
+     * Sweeps of more than UINT32_MAX settings are rejected.
+     */
+    status_t run(std::function<bool(uint32_t, const HSIC&, int32_t)> fn, uint32_t& failed,
+                 uint32_t threads = 0) const;
+
+  private:
+    HSICRanges mRanges;
+    Range mBalance;
+    uint32_t mSteps;
+};
+};
+
+#endif
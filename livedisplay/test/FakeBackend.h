@@ -0,0 +1,211 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAY_FAKEBACKEND_H
+#define CYNGN_LIVEDISPLAY_FAKEBACKEND_H
+
+#include <string.h>
+
+#include <utils/Mutex.h>
+
+#include "LiveDisplayBackend.h"
+
+namespace android {
+
+/*
+ * In-memory backend with every feature and a fixed set of display
+ * modes, for running LiveDisplay plumbing on the host. Values are
+ * stored as they are set, checked against the reported ranges.
+ */
+class FakeBackend : public LiveDisplayBackend {
+  public:
+    static const int32_t MODE_COUNT = 3;
+
+    FakeBackend()
+        : mInitialized(false),
+          mCalls(0),
+          mAdaptiveBacklight(false),
+          mOutdoorMode(false),
+          mColorBalance(0),
+          mModeId(0),
+          mDefaultModeId(0),
+          mPictureAdjustment(0, 0.0f, 0.0f, 0.0f, 0.0f) {
+    }
+
+    virtual status_t initialize() {
+        Mutex::Autolock _l(mLock);
+        mInitialized = true;
+        return OK;
+    }
+
+    virtual status_t deinitialize() {
+        Mutex::Autolock _l(mLock);
+        mInitialized = false;
+        return OK;
+    }
+
+    virtual bool hasFeature(Feature feature) {
+        return (feature & getSupportedFeatures()) != 0;
+    }
+
+    virtual uint32_t getSupportedFeatures() {
+        return Feature::DISPLAY_MODES | Feature::COLOR_TEMPERATURE | Feature::OUTDOOR_MODE |
+               Feature::ADAPTIVE_BACKLIGHT | Feature::PICTURE_ADJUSTMENT;
+    }
+
+    virtual status_t setAdaptiveBacklightEnabled(bool enabled) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        mAdaptiveBacklight = enabled;
+        return OK;
+    }
+
+    virtual bool isAdaptiveBacklightEnabled() {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        return mAdaptiveBacklight;
+    }
+
+    virtual status_t setOutdoorModeEnabled(bool enabled) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        mOutdoorMode = enabled;
+        return OK;
+    }
+
+    virtual bool isOutdoorModeEnabled() {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        return mOutdoorMode;
+    }
+
+    virtual status_t getColorBalanceRange(Range& range) {
+        range = Range(-100, 100);
+        return OK;
+    }
+
+    virtual status_t setColorBalance(int32_t balance) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        if (balance < -100 || balance > 100) {
+            return BAD_VALUE;
+        }
+        mColorBalance = balance;
+        return OK;
+    }
+
+    virtual int32_t getColorBalance() {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        return mColorBalance;
+    }
+
+    virtual status_t getDisplayModes(List<sp<DisplayMode>>& profiles) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        for (int32_t i = 0; i < MODE_COUNT; i++) {
+            profiles.push_back(makeMode(i));
+        }
+        return OK;
+    }
+
+    virtual status_t setDisplayMode(int32_t modeID, bool makeDefault) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        if (modeID < 0 || modeID >= MODE_COUNT) {
+            return BAD_VALUE;
+        }
+        mModeId = modeID;
+        if (makeDefault) {
+            mDefaultModeId = modeID;
+        }
+        return OK;
+    }
+
+    virtual sp<DisplayMode> getCurrentDisplayMode() {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        return makeMode(mModeId);
+    }
+
+    virtual sp<DisplayMode> getDefaultDisplayMode() {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        return makeMode(mDefaultModeId);
+    }
+
+    virtual status_t getPictureAdjustmentRanges(HSICRanges& ranges) {
+        ranges = HSICRanges(Range(-180, 180), FloatRange(-1.0f, 1.0f), FloatRange(-1.0f, 1.0f),
+                            FloatRange(-1.0f, 1.0f), FloatRange(0.0f, 1.0f));
+        return OK;
+    }
+
+    virtual status_t getPictureAdjustment(HSIC& hsic) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        hsic = mPictureAdjustment;
+        return OK;
+    }
+
+    virtual status_t getDefaultPictureAdjustment(HSIC& hsic) {
+        hsic = HSIC(0, 0.0f, 0.0f, 0.0f, 0.0f);
+        return OK;
+    }
+
+    virtual status_t setPictureAdjustment(HSIC hsic) {
+        Mutex::Autolock _l(mLock);
+        mCalls++;
+        if (hsic.hue < -180 || hsic.hue > 180) {
+            return BAD_VALUE;
+        }
+        mPictureAdjustment = hsic;
+        return OK;
+    }
+
+    // Number of get and set calls which reached the backend
+    uint32_t calls() {
+        Mutex::Autolock _l(mLock);
+        return mCalls;
+    }
+
+    bool isInitialized() {
+        Mutex::Autolock _l(mLock);
+        return mInitialized;
+    }
+
+  private:
+    static sp<DisplayMode> makeMode(int32_t id) {
+        static const char* const names[MODE_COUNT] = {"standard", "vivid", "srgb"};
+        sp<DisplayMode> mode = new DisplayMode(id, names[id], strlen(names[id]));
+        mode->privFlags = 0;
+        return mode;
+    }
+
+    Mutex mLock;
+    bool mInitialized;
+    uint32_t mCalls;
+
+    bool mAdaptiveBacklight;
+    bool mOutdoorMode;
+    int32_t mColorBalance;
+    int32_t mModeId;
+    int32_t mDefaultModeId;
+    HSIC mPictureAdjustment;
+};
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#ifndef CYNGN_LIVEDISPLAY_SWEEPDUMP_H
+#define CYNGN_LIVEDISPLAY_SWEEPDUMP_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include <Types.h>
+
+namespace android {
+
+/*
+ * Device dump written by livedisplay_vendor_sweep and read by the golden
+ * test: the ranges the vendor backend reported, followed by what it read
+ * back for every setting of a sweep over them, in sweep order.
+ */
+
+#define SWEEP_DUMP_MAGIC 0x5044444c  // "LDDP"
+#define SWEEP_DUMP_VERSION 1
+
+struct sweep_ranges {
+    int32_t hueMin, hueMax;
+    float saturationMin, saturationMax;
+    float intensityMin, intensityMax;
+    float contrastMin, contrastMax;
+    float thresholdMin, thresholdMax;
+    int32_t balanceMin, balanceMax;
+};
+
+struct sweep_dump_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t steps;
+    uint32_t count;
+    char platform[32];
+    struct sweep_ranges ranges;
+};
+
+struct sweep_readback {
+    int32_t hue;
+    float saturation;
+    float intensity;
+    float contrast;
+    float saturationThreshold;
+    int32_t balance;
+    int32_t status;  // of the set and get, OK if both succeeded
+};
+
+static inline void fromRanges(const HSICRanges& hsic, const Range& balance, sweep_ranges& r) {
+    r.hueMin = hsic.hue.min;
+    r.hueMax = hsic.hue.max;
+    r.saturationMin = hsic.saturation.min;
+    r.saturationMax = hsic.saturation.max;
+    r.intensityMin = hsic.intensity.min;
+    r.intensityMax = hsic.intensity.max;
+    r.contrastMin = hsic.contrast.min;
+    r.contrastMax = hsic.contrast.max;
+    r.thresholdMin = hsic.saturationThreshold.min;
+    r.thresholdMax = hsic.saturationThreshold.max;
+    r.balanceMin = balance.min;
+    r.balanceMax = balance.max;
+}
+
+static inline HSICRanges toRanges(const sweep_ranges& r) {
+    HSICRanges ranges;
+    ranges.hue = Range(r.hueMin, r.hueMax);
+    ranges.saturation = FloatRange(r.saturationMin, r.saturationMax);
+    ranges.intensity = FloatRange(r.intensityMin, r.intensityMax);
+    ranges.contrast = FloatRange(r.contrastMin, r.contrastMax);
+    ranges.saturationThreshold = FloatRange(r.thresholdMin, r.thresholdMax);
+    return ranges;
+}
+
+static inline Range toBalanceRange(const sweep_ranges& r) {
+    return Range(r.balanceMin, r.balanceMax);
+}
+
+static inline bool sameRanges(const sweep_ranges& a, const sweep_ranges& b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static inline bool readSweepDump(const char* path, sweep_dump_header& h,
+                                 std::vector<sweep_readback>& readback) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Unable to read %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    bool ok = fread(&h, sizeof(h), 1, fp) == 1 && h.magic == SWEEP_DUMP_MAGIC &&
+              h.version == SWEEP_DUMP_VERSION;
+    if (ok) {
+        h.platform[sizeof(h.platform) - 1] = '\0';
+        readback.resize(h.count);
+        ok = h.count == 0 ||
+             fread(readback.data(), sizeof(sweep_readback), h.count, fp) == h.count;
+    }
+    fclose(fp);
+    if (!ok) {
+        fprintf(stderr, "%s is not a complete sweep dump\n", path);
+    }
+    return ok;
+}
+
+static inline bool writeSweepDump(const char* path, const sweep_dump_header& h,
+                                  const std::vector<sweep_readback>& readback) {
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Unable to write %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+              (readback.empty() ||
+               fwrite(readback.data(), sizeof(sweep_readback), readback.size(), fp) ==
+                       readback.size());
+    ok &= fclose(fp) == 0;
+    if (!ok) {
+        fprintf(stderr, "Unable to write %s\n", path);
+    }
+    return ok;
+}
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#include <cutils/properties.h>
+#include <utils/Timers.h>
+
+#include "BenchUtils.h"
+#include "LegacyMM.h"
+#include "SDM.h"
+#include "VendorLibrary.h"
+
+/*
+ * Times opening the platform vendor library and binding its symbols,
+ * each run in a new process so the library is loaded cold:
+ *
+ *   eager       dlopen(RTLD_NOW) and dlsym() of every symbol up front
+ *   table, now  VendorLibrary binding its whole table at open
+ *   table, lazy VendorLibrary binding only the required symbols at open
+ *   lazy+probe  the above, then every feature's symbols as a probe would
+ *
+ * usage: livedisplay_bind_bench [runs]
+ */
+
+#define DEFAULT_RUNS 10
+
+using namespace android;
+
+struct symbol_entry {
+    const char* name;
+    uint32_t features;
+};
+
+// Kept in step with the VendorFunction tables in SDM.h and LegacyMM.h
+static const symbol_entry kSdmSymbols[] = {
+    {"disp_api_init", VENDOR_REQUIRED},
+    {"disp_api_deinit", VENDOR_REQUIRED},
+    {"disp_api_get_feature_version", VENDOR_REQUIRED},
+    {"disp_api_get_global_color_balance_range", Feature::COLOR_TEMPERATURE},
+    {"disp_api_set_global_color_balance", Feature::COLOR_TEMPERATURE},
+    {"disp_api_get_global_color_balance", Feature::COLOR_TEMPERATURE},
+    {"disp_api_get_num_display_modes", Feature::DISPLAY_MODES | Feature::COLOR_TEMPERATURE},
+    {"disp_api_get_display_modes", Feature::DISPLAY_MODES},
+    {"disp_api_get_active_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_set_active_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_set_default_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_get_default_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_get_global_pa_range", Feature::PICTURE_ADJUSTMENT},
+    {"disp_api_get_global_pa_config", Feature::PICTURE_ADJUSTMENT},
+    {"disp_api_set_global_pa_config", Feature::PICTURE_ADJUSTMENT},
+};
+
+static const symbol_entry kMmSymbols[] = {
+    {"disp_api_init", VENDOR_REQUIRED},
+    {"disp_api_supported", VENDOR_REQUIRED},
+    {"disp_api_get_color_balance_range", Feature::COLOR_TEMPERATURE},
+    {"disp_api_set_color_balance", Feature::COLOR_TEMPERATURE},
+    {"disp_api_get_color_balance", Feature::COLOR_TEMPERATURE},
+    {"disp_api_get_num_display_modes", Feature::DISPLAY_MODES | Feature::COLOR_TEMPERATURE},
+    {"disp_api_get_display_modes", Feature::DISPLAY_MODES},
+    {"disp_api_get_active_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_set_active_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_set_default_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_get_default_display_mode", Feature::DISPLAY_MODES},
+    {"disp_api_get_pa_range", Feature::PICTURE_ADJUSTMENT},
+    {"disp_api_get_pa_config", Feature::PICTURE_ADJUSTMENT},
+    {"disp_api_set_pa_config", Feature::PICTURE_ADJUSTMENT},
+};
+
+enum Strategy { EAGER, TABLE_NOW, TABLE_LAZY, TABLE_LAZY_PROBE, STRATEGY_COUNT };
+
+static const char* const kStrategyNames[STRATEGY_COUNT] = {
+    "eager", "table, now", "table, lazy", "lazy+probe",
+};
+
+static const char* sPath;
+static const symbol_entry* sSymbols;
+static size_t sSymbolCount;
+
+// Time to open and bind in ns, negative if the library couldn't be used
+static int64_t openAndBind(Strategy strategy) {
+    if (strategy == EAGER) {
+        nsecs_t start = systemTime();
+        void* handle = dlopen(sPath, RTLD_NOW);
+        if (handle == NULL) {
+            return -1;
+        }
+        for (size_t i = 0; i < sSymbolCount; i++) {
+            dlsym(handle, sSymbols[i].name);
+        }
+        nsecs_t elapsed = systemTime() - start;
+        dlclose(handle);
+        return elapsed;
+    }
+
+    VendorLibrary lib(sPath);
+    std::vector<std::unique_ptr<VendorSymbol>> symbols;
+    for (size_t i = 0; i < sSymbolCount; i++) {
+        symbols.emplace_back(new VendorSymbol(lib, sSymbols[i].name, sSymbols[i].features));
+    }
+
+    nsecs_t start = systemTime();
+    if (lib.open(strategy == TABLE_NOW) != OK) {
+        return -1;
+    }
+    if (strategy == TABLE_LAZY_PROBE) {
+        for (uint32_t f = 1; f <= (uint32_t)Feature::MAX; f <<= 1) {
+            lib.provides(f);
+        }
+    }
+    nsecs_t elapsed = systemTime() - start;
+
+    // The symbols go before the library, which would reset them on close
+    lib.close();
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : DEFAULT_RUNS;
+    if (runs <= 0) {
+        fprintf(stderr, "usage: %s [runs]\n", argv[0]);
+        return 1;
+    }
+
+    char board[PROPERTY_VALUE_MAX];
+    property_get("ro.board.platform", board, NULL);
+    if (!strcmp(board, "msm8916") || !strcmp(board, "msm8939") || !strcmp(board, "msm8992") ||
+        !strcmp(board, "msm8974") || !strcmp(board, "msm8994")) {
+        sPath = MM_DISP_LIB;
+        sSymbols = kMmSymbols;
+        sSymbolCount = sizeof(kMmSymbols) / sizeof(kMmSymbols[0]);
+    } else if (!strcmp(board, "msm8996") || !strcmp(board, "msm8937") ||
+               !strcmp(board, "msm8953") || !strcmp(board, "msm8976")) {
+        sPath = SDM_DISP_LIB;
+        sSymbols = kSdmSymbols;
+        sSymbolCount = sizeof(kSdmSymbols) / sizeof(kSdmSymbols[0]);
+    } else {
+        fprintf(stderr, "No vendor library on this platform\n");
+        return 1;
+    }
+    printf("%s, %zu symbols\n", sPath, sSymbolCount);
+
+    for (int s = 0; s < STRATEGY_COUNT; s++) {
+        Strategy strategy = static_cast<Strategy>(s);
+        nsecs_t total = 0;
+        for (int n = 0; n < runs; n++) {
+            int64_t elapsed;
+            if (!runInChild([=] { return openAndBind(strategy); }, elapsed)) {
+                fprintf(stderr, "Unable to open %s\n", sPath);
+                return 1;
+            }
+            total += elapsed;
+        }
+        printf("%-12s %8.1f us (%d runs)\n", kStrategyNames[s], ns2us(total) / (double)runs,
+               runs);
+    }
+    return 0;
+}
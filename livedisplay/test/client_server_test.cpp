@@ -0,0 +1,201 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <functional>
+#include <thread>
+
+#include "FakeBackend.h"
+#include "LiveDisplayClient.h"
+#include "LiveDisplayServer.h"
+#include "RemoteBackend.h"
+
+/*
+ * End-to-end run of LiveDisplayClient and RemoteBackend against
+ * LiveDisplayServer over socketpairs, with FakeBackend standing in for
+ * the vendor backend.
+ *
+ * usage: livedisplay_client_server_test
+ */
+
+using namespace android;
+
+static int sFailures = 0;
+
+#define EXPECT(cond)                                                  \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            fprintf(stderr, "%s:%d: FAILED %s\n", __FILE__, __LINE__, \
+                    #cond);                                           \
+            sFailures++;                                              \
+        }                                                             \
+    } while (0)
+
+static void testCalls(LiveDisplayClient& client, FakeBackend& backend) {
+    EXPECT(client.getSupportedFeatures() == backend.getSupportedFeatures());
+
+    EXPECT(client.setAdaptiveBacklightEnabled(true) == OK);
+    EXPECT(client.isAdaptiveBacklightEnabled());
+    EXPECT(client.setOutdoorModeEnabled(true) == OK);
+    EXPECT(client.isOutdoorModeEnabled());
+    EXPECT(client.setOutdoorModeEnabled(false) == OK);
+    EXPECT(!client.isOutdoorModeEnabled());
+
+    Range range;
+    EXPECT(client.getColorBalanceRange(range) == OK);
+    EXPECT(range.min == -100 && range.max == 100);
+    EXPECT(client.setColorBalance(42) == OK);
+    EXPECT(client.getColorBalance() == 42);
+    EXPECT(client.setColorBalance(1000) == BAD_VALUE);
+    EXPECT(client.getColorBalance() == 42);
+
+    // Errors from the backend come back as they are
+    EXPECT(client.getColorTemperatureRange(range) == INVALID_OPERATION);
+
+    List<sp<DisplayMode>> modes;
+    EXPECT(client.getDisplayModes(modes) == OK);
+    EXPECT(modes.size() == (size_t)FakeBackend::MODE_COUNT);
+    if (!modes.empty()) {
+        EXPECT(!strcmp((*modes.begin())->name.string(), "standard"));
+    }
+
+    EXPECT(client.setDisplayMode(2, true) == OK);
+    sp<DisplayMode> mode = client.getCurrentDisplayMode();
+    EXPECT(mode != NULL && mode->id == 2 && !strcmp(mode->name.string(), "srgb"));
+    mode = client.getDefaultDisplayMode();
+    EXPECT(mode != NULL && mode->id == 2);
+    EXPECT(client.setDisplayMode(FakeBackend::MODE_COUNT, false) == BAD_VALUE);
+
+    HSICRanges ranges;
+    EXPECT(client.getPictureAdjustmentRanges(ranges) == OK);
+    EXPECT(ranges.hue.min == -180 && ranges.hue.max == 180);
+    EXPECT(ranges.saturationThreshold.max == 1.0f);
+
+    HSIC hsic(10, 0.25f, -0.5f, 0.75f, 0.5f);
+    EXPECT(client.setPictureAdjustment(hsic) == OK);
+    HSIC out;
+    EXPECT(client.getPictureAdjustment(out) == OK);
+    EXPECT(out == hsic);
+}
+
+static void testBatch(LiveDisplayClient& client, FakeBackend& backend) {
+    LiveDisplayBatch batch;
+    size_t setMode = batch.setDisplayMode(1, false);
+    size_t setBalance = batch.add(OP_SET_COLOR_BALANCE, -7);
+    size_t getBalance = batch.add(OP_GET_COLOR_BALANCE);
+    size_t getModes = batch.add(OP_GET_DISPLAY_MODES);
+    size_t getModesAgain = batch.add(OP_GET_DISPLAY_MODES);
+    size_t bad = batch.setDisplayMode(-1, false);
+
+    uint32_t calls = backend.calls();
+    EXPECT(client.execute(batch) == OK);
+
+    // Every request reached the backend, in order, in one round trip
+    EXPECT(backend.calls() - calls == batch.size());
+    EXPECT(batch.status(setMode) == OK);
+    EXPECT(batch.status(setBalance) == OK);
+    EXPECT(batch.status(getBalance) == OK);
+    EXPECT(batch.response(getBalance).value == -7);
+    EXPECT(batch.status(bad) == BAD_VALUE);
+
+    List<sp<DisplayMode>> modes;
+    batch.getDisplayModes(getModes, modes);
+    EXPECT(modes.size() == (size_t)FakeBackend::MODE_COUNT);
+    modes.clear();
+    batch.getDisplayModes(getModesAgain, modes);
+    EXPECT(modes.size() == (size_t)FakeBackend::MODE_COUNT);
+
+    sp<DisplayMode> mode = client.getCurrentDisplayMode();
+    EXPECT(mode != NULL && mode->id == 1);
+
+    // Too many requests are refused before anything is sent
+    batch.clear();
+    for (int i = 0; i <= LIVEDISPLAY_MAX_BATCH; i++) {
+        batch.add(OP_GET_COLOR_BALANCE);
+    }
+    calls = backend.calls();
+    EXPECT(client.execute(batch) == BAD_VALUE);
+    EXPECT(backend.calls() == calls);
+}
+
+static void testRemoteBackend(RemoteBackend& remote, FakeBackend& backend) {
+    EXPECT(remote.initialize() == OK);
+    EXPECT(remote.getSupportedFeatures() == backend.getSupportedFeatures());
+    EXPECT(remote.hasFeature(Feature::PICTURE_ADJUSTMENT));
+
+    EXPECT(remote.setColorBalance(-3) == OK);
+    EXPECT(backend.getColorBalance() == -3);
+
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+    EXPECT(remote.getDisplayModeRecords(records, MAX_DISPLAY_MODES, count) == OK);
+    EXPECT(count == (size_t)FakeBackend::MODE_COUNT);
+
+    // Only hangs up, the backend stays up for other clients
+    EXPECT(remote.deinitialize() == OK);
+    EXPECT(!remote.hasFeature(Feature::PICTURE_ADJUSTMENT));
+    EXPECT(backend.isInitialized());
+}
+
+// Serves one client on a socketpair, which is hung up once test returns
+static void withServer(LiveDisplayServer& server, std::function<void(int)> test) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        perror("socketpair");
+        sFailures++;
+        return;
+    }
+
+    status_t served = UNKNOWN_ERROR;
+    std::thread thread([&] { served = server.serve(fds[1]); });
+
+    test(fds[0]);
+
+    // Hanging up ends the server loop
+    shutdown(fds[0], SHUT_RDWR);
+    thread.join();
+    close(fds[0]);
+    close(fds[1]);
+    EXPECT(served == DEAD_OBJECT);
+}
+
+int main() {
+    FakeBackend backend;
+    LiveDisplayServer server(backend);
+
+    withServer(server, [&](int fd) {
+        LiveDisplayClient client(fd);
+        testCalls(client, backend);
+        testBatch(client, backend);
+    });
+
+    withServer(server, [&](int fd) {
+        RemoteBackend remote(fd);
+        testRemoteBackend(remote, backend);
+    });
+
+    if (sFailures > 0) {
+        fprintf(stderr, "%d checks failed\n", sFailures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
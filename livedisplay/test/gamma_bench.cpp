@@ -0,0 +1,71 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <utils/Timers.h>
+
+#include "GammaLut.h"
+
+/*
+ * Times GammaLut::generate() for every supported table size.
+ *
+ * usage: livedisplay_gamma_bench [iterations]
+ */
+
+#define DEFAULT_ITERATIONS 1000
+
+using namespace android;
+
+static GammaLut sLut;
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    LutParams params;
+    params.gamma[GammaLut::RED] = 2.2f;
+    params.gamma[GammaLut::GREEN] = 2.2f;
+    params.gamma[GammaLut::BLUE] = 2.4f;
+    params.gain[GammaLut::BLUE] = 0.95f;
+    params.contrast = 0.1f;
+    params.intensity = -0.05f;
+
+    const size_t sizes[] = {256, 1024, 4096};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        // Warm up the caches and check the parameters once
+        if (sLut.generate(sizes[i], params) != OK) {
+            fprintf(stderr, "Failed to generate a %zu entry table\n", sizes[i]);
+            return 1;
+        }
+
+        nsecs_t start = systemTime();
+        for (int n = 0; n < iterations; n++) {
+            sLut.generate(sizes[i], params);
+        }
+        nsecs_t elapsed = systemTime() - start;
+
+        printf("%4zu entries: %8.2f us/table (%d tables)\n", sizes[i],
+               ns2us(elapsed) / (double)iterations, iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,320 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <utils/Timers.h>
+
+#include "ColorDiff.h"
+#include "ColorPipeline.h"
+#include "SweepDump.h"
+
+/*
+ * Golden-image regression run for the reference color pipeline. Every
+ * setting in a sweep over the picture adjustment and color balance
+ * ranges is rendered onto a small chart and compared in CIELAB against
+ * the stored golden for that setting.
+ *
+ * The ranges and the number of steps come from a device dump recorded
+ * with livedisplay_vendor_sweep. Given the dump, the check also fails if
+ * the ranges changed, and renders what the vendor backend read back for
+ * each setting against the golden for the setting that was requested.
+ *
+ * usage: livedisplay_golden_test [-t tolerance] [-j threads] [-d dump] golden
+ *        livedisplay_golden_test -r -d dump golden
+ *
+ * -r rewrites the goldens, after an intended change to the pipeline.
+ */
+
+#define GOLDEN_MAGIC 0x4447444c  // "LDGD"
+#define GOLDEN_VERSION 1
+
+#define CHART_WIDTH 8
+#define CHART_HEIGHT 4
+#define CHART_BYTES (CHART_WIDTH * CHART_HEIGHT * 4)
+
+#define DEFAULT_TOLERANCE 1.0f
+#define MAX_REPORTED 10
+
+using namespace android;
+
+struct golden_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t steps;
+    uint32_t width;
+    uint32_t height;
+    struct sweep_ranges ranges;
+};
+
+static void hsvToRgb(float h, float s, float v, uint8_t* out) {
+    float c = v * s;
+    float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
+    float m = v - c;
+    float r = 0, g = 0, b = 0;
+
+    if (h < 60) {
+        r = c, g = x;
+    } else if (h < 120) {
+        r = x, g = c;
+    } else if (h < 180) {
+        g = c, b = x;
+    } else if (h < 240) {
+        g = x, b = c;
+    } else if (h < 300) {
+        r = x, b = c;
+    } else {
+        r = c, b = x;
+    }
+    out[0] = (uint8_t)lroundf((r + m) * 255.0f);
+    out[1] = (uint8_t)lroundf((g + m) * 255.0f);
+    out[2] = (uint8_t)lroundf((b + m) * 255.0f);
+    out[3] = 0xff;
+}
+
+/*
+ * One column per hue, with rows of saturated, pastel and dark colors
+ * and a gray ramp underneath.
+ */
+static void makeChart(uint8_t* chart) {
+    for (int x = 0; x < CHART_WIDTH; x++) {
+        float hue = x * 360.0f / CHART_WIDTH;
+        float gray = x / (float)(CHART_WIDTH - 1);
+        hsvToRgb(hue, 1.0f, 1.0f, chart + (0 * CHART_WIDTH + x) * 4);
+        hsvToRgb(hue, 0.4f, 0.9f, chart + (1 * CHART_WIDTH + x) * 4);
+        hsvToRgb(hue, 0.8f, 0.35f, chart + (2 * CHART_WIDTH + x) * 4);
+        hsvToRgb(0.0f, 0.0f, gray, chart + (3 * CHART_WIDTH + x) * 4);
+    }
+}
+
+static void render(const uint8_t* chart, const HSICRanges& ranges, const Range& balanceRange,
+                   const HSIC& hsic, int32_t balance, uint8_t* out) {
+    ColorPipeline pipeline;
+    pipeline.setPictureAdjustment(hsic, ranges);
+    pipeline.setColorBalance(balance, balanceRange);
+    pipeline.process(chart, out, CHART_WIDTH, CHART_HEIGHT, CHART_WIDTH, 1);
+}
+
+static HSIC toHSIC(const sweep_readback& r) {
+    return HSIC(r.hue, r.saturation, r.intensity, r.contrast, r.saturationThreshold);
+}
+
+static int record(const char* path, const char* dumpPath) {
+    sweep_dump_header dump;
+    std::vector<sweep_readback> readback;
+    if (!readSweepDump(dumpPath, dump, readback)) {
+        return 1;
+    }
+
+    golden_header h;
+    memset(&h, 0, sizeof(h));
+    h.magic = GOLDEN_MAGIC;
+    h.version = GOLDEN_VERSION;
+    h.steps = dump.steps;
+    h.width = CHART_WIDTH;
+    h.height = CHART_HEIGHT;
+    h.ranges = dump.ranges;
+
+    HSICRanges ranges = toRanges(h.ranges);
+    Range balanceRange = toBalanceRange(h.ranges);
+    ColorSweep sweep(ranges, balanceRange, h.steps);
+    if (sweep.size() * CHART_BYTES > 64 * 1024 * 1024) {
+        fprintf(stderr, "%u steps makes too many goldens\n", h.steps);
+        return 1;
+    }
+
+    uint8_t chart[CHART_BYTES];
+    makeChart(chart);
+
+    std::vector<uint8_t> images(sweep.size() * CHART_BYTES);
+    uint32_t failed = 0;
+    sweep.run([&](uint32_t i, const HSIC& hsic, int32_t balance) {
+        render(chart, ranges, balanceRange, hsic, balance, &images[(size_t)i * CHART_BYTES]);
+        return true;
+    }, failed);
+
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Unable to write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+              fwrite(images.data(), images.size(), 1, fp) == 1;
+    ok &= fclose(fp) == 0;
+    if (!ok) {
+        fprintf(stderr, "Unable to write %s\n", path);
+        return 1;
+    }
+
+    printf("Recorded %" PRIu64 " goldens for %s in %s\n", sweep.size(), dump.platform, path);
+    return 0;
+}
+
+static int check(const char* path, const char* dumpPath, float tolerance, uint32_t threads) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Unable to read %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    golden_header h;
+    if (fread(&h, sizeof(h), 1, fp) != 1 || h.magic != GOLDEN_MAGIC ||
+            h.version != GOLDEN_VERSION || h.width != CHART_WIDTH ||
+            h.height != CHART_HEIGHT) {
+        fprintf(stderr, "%s is not a golden file for this harness\n", path);
+        fclose(fp);
+        return 1;
+    }
+
+    HSICRanges ranges = toRanges(h.ranges);
+    Range balanceRange = toBalanceRange(h.ranges);
+    ColorSweep sweep(ranges, balanceRange, h.steps);
+    if (sweep.size() * CHART_BYTES > 64 * 1024 * 1024) {
+        fprintf(stderr, "%s has too many goldens\n", path);
+        fclose(fp);
+        return 1;
+    }
+
+    sweep_dump_header dump;
+    std::vector<sweep_readback> readback;
+    if (dumpPath != NULL) {
+        if (!readSweepDump(dumpPath, dump, readback)) {
+            fclose(fp);
+            return 1;
+        }
+        if (!sameRanges(dump.ranges, h.ranges) || dump.steps != h.steps ||
+                dump.count != sweep.size()) {
+            fprintf(stderr, "%s reports other ranges than %s was recorded for\n", dumpPath,
+                    path);
+            fclose(fp);
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> goldens(sweep.size() * CHART_BYTES);
+    bool complete = fread(goldens.data(), goldens.size(), 1, fp) == 1;
+    fclose(fp);
+    if (!complete) {
+        fprintf(stderr, "%s is truncated\n", path);
+        return 1;
+    }
+
+    uint8_t chart[CHART_BYTES];
+    makeChart(chart);
+
+    std::atomic<uint32_t> reported(0);
+    std::vector<float> worst(sweep.size());
+
+    nsecs_t start = systemTime();
+    uint32_t failed = 0;
+    sweep.run([&](uint32_t i, const HSIC& hsic, int32_t balance) {
+        uint8_t out[CHART_BYTES];
+        render(chart, ranges, balanceRange, hsic, balance, out);
+
+        const uint8_t* golden = &goldens[(size_t)i * CHART_BYTES];
+        DeltaEStats stats;
+        ColorDiff::compare(out, golden, CHART_WIDTH, CHART_HEIGHT, CHART_WIDTH, tolerance,
+                           stats, 1);
+        worst[i] = stats.max;
+        const char* what = "pipeline";
+        if (stats.exceeded == 0 && !readback.empty()) {
+            // What the vendor applied, against the reference for what was asked
+            const sweep_readback& r = readback[i];
+            if (r.status != OK) {
+                stats.exceeded = CHART_WIDTH * CHART_HEIGHT;
+            } else {
+                render(chart, ranges, balanceRange, toHSIC(r), r.balance, out);
+                ColorDiff::compare(out, golden, CHART_WIDTH, CHART_HEIGHT, CHART_WIDTH,
+                                   tolerance, stats, 1);
+                worst[i] = std::max(worst[i], stats.max);
+            }
+            what = "vendor";
+        }
+        if (stats.exceeded == 0) {
+            return true;
+        }
+        if (reported++ < MAX_REPORTED) {
+            fprintf(stderr,
+                    "FAIL %u (%s): hue=%d sat=%.3f int=%.3f con=%.3f thr=%.3f balance=%d: "
+                    "%u pixels over, max deltaE %.2f\n",
+                    i, what, hsic.hue, hsic.saturation, hsic.intensity, hsic.contrast,
+                    hsic.saturationThreshold, balance, stats.exceeded, stats.max);
+        }
+        return false;
+    }, failed, threads);
+    nsecs_t elapsed = systemTime() - start;
+
+    float max = 0.0f;
+    for (size_t i = 0; i < worst.size(); i++) {
+        max = std::max(max, worst[i]);
+    }
+    printf("%" PRIu64 " settings, %u failed, max deltaE %.3f (tolerance %.2f), %" PRId64 "ms\n",
+           sweep.size(), failed, max, tolerance, ns2ms(elapsed));
+    return failed == 0 ? 0 : 1;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-t tolerance] [-j threads] [-d dump] golden\n", name);
+    fprintf(stderr, "       %s -r -d dump golden\n", name);
+}
+
+int main(int argc, char** argv) {
+    bool recording = false;
+    const char* dumpPath = NULL;
+    uint32_t threads = 0;
+    float tolerance = DEFAULT_TOLERANCE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "rd:t:j:")) != -1) {
+        switch (opt) {
+            case 'r':
+                recording = true;
+                break;
+            case 'd':
+                dumpPath = optarg;
+                break;
+            case 't':
+                tolerance = atof(optarg);
+                break;
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || (recording && dumpPath == NULL)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (recording) {
+        return record(argv[optind], dumpPath);
+    }
+    return check(argv[optind], dumpPath, tolerance, threads);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.cyanogenmod.hardware.tests;
+
+import org.cyanogenmod.hardware.LiveDisplayVendorImpl;
+
+/**
+ * Reports the per-call cost of the LiveDisplay JNI getters, each next to
+ * its lock free native_peek counterpart, with an empty Java call as a
+ * baseline. Each getter is called once before timing so the value is
+ * served from the native shadow.
+ *
+ * usage: CLASSPATH=/system/framework/livedisplay_jni_bench.jar \
+ *            app_process /system/bin org.cyanogenmod.hardware.tests.LiveDisplayJniBench [calls]
+ */
+public class LiveDisplayJniBench {
+
+    private static final int DEFAULT_CALLS = 1000000;
+
+    private interface Getter {
+        int call();
+    }
+
+    private static int sSink;
+
+    private static int baseline() {
+        return sSink;
+    }
+
+    private static void run(String name, Getter getter, int calls) {
+        getter.call();
+
+        int sink = 0;
+        final long start = System.nanoTime();
+        for (int i = 0; i < calls; i++) {
+            sink += getter.call();
+        }
+        final long elapsed = System.nanoTime() - start;
+        sSink += sink;
+
+        System.out.println(String.format("%-34s %8.1f ns/call", name, (double) elapsed / calls));
+    }
+
+    public static void main(String[] args) {
+        final int calls = args.length > 0 ? Integer.parseInt(args[0]) : DEFAULT_CALLS;
+        if (calls <= 0) {
+            System.err.println("usage: LiveDisplayJniBench [calls]");
+            System.exit(1);
+        }
+
+        run("java baseline", new Getter() {
+            public int call() {
+                return baseline();
+            }
+        }, calls);
+
+        run("native_peekSupportedFeatures", new Getter() {
+            public int call() {
+                return LiveDisplayVendorImpl.native_peekSupportedFeatures();
+            }
+        }, calls);
+
+        if (LiveDisplayVendorImpl.hasNativeFeature(LiveDisplayVendorImpl.COLOR_BALANCE)) {
+            run("native_getColorBalance", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_getColorBalance();
+                }
+            }, calls);
+            run("native_peekColorBalance", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_peekColorBalance();
+                }
+            }, calls);
+            run("native_getColorTemperature", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_getColorTemperature();
+                }
+            }, calls);
+            run("native_peekColorTemperature", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_peekColorTemperature();
+                }
+            }, calls);
+        }
+        if (LiveDisplayVendorImpl.hasNativeFeature(LiveDisplayVendorImpl.OUTDOOR_MODE)) {
+            run("native_isOutdoorModeEnabled", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_isOutdoorModeEnabled() ? 1 : 0;
+                }
+            }, calls);
+            run("native_peekOutdoorMode", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_peekOutdoorMode();
+                }
+            }, calls);
+        }
+        if (LiveDisplayVendorImpl.hasNativeFeature(LiveDisplayVendorImpl.ADAPTIVE_BACKLIGHT)) {
+            run("native_isAdaptiveBacklightEnabled", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_isAdaptiveBacklightEnabled() ? 1 : 0;
+                }
+            }, calls);
+            run("native_peekAdaptiveBacklight", new Getter() {
+                public int call() {
+                    return LiveDisplayVendorImpl.native_peekAdaptiveBacklight();
+                }
+            }, calls);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <new>
+
+#include <utils/Timers.h>
+
+#include "BenchUtils.h"
+#include "LiveDisplay.h"
+
+/*
+ * Counts the heap allocations and time of one display mode enumeration,
+ * through getDisplayModes() and through getDisplayModeRecords(), on the
+ * backend LiveDisplay would use. The backend is called directly, since
+ * the backend executor allocates for every call. The same is reported
+ * for LiveDisplay::getDisplayModeRecords(), whose first call lists the
+ * modes through the executor and later calls copy them.
+ *
+ * Only operator new is counted. The String8 names of getDisplayModes()
+ * come from malloc, so its count is a lower bound.
+ *
+ * usage: livedisplay_modes_bench [iterations]
+ */
+
+#define DEFAULT_ITERATIONS 1000
+
+using namespace android;
+
+static std::atomic<uint64_t> sAllocations(0);
+
+void* operator new(size_t size) {
+    sAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+static void report(const char* name, uint64_t allocations, nsecs_t elapsed, int iterations) {
+    printf("%-24s %8.2f allocs/call %8.2f us/call\n", name,
+           allocations / (double)iterations, ns2us(elapsed) / (double)iterations);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    LiveDisplayBackend* backend = createBackend();
+    if (backend == NULL) {
+        fprintf(stderr, "No LiveDisplay backend on this device\n");
+        return 1;
+    }
+    if (backend->initialize() != OK || !backend->hasFeature(Feature::DISPLAY_MODES)) {
+        fprintf(stderr, "Display modes are not available\n");
+        delete backend;
+        return 1;
+    }
+
+    DisplayModeRecord records[MAX_DISPLAY_MODES];
+    size_t count = 0;
+    if (backend->getDisplayModeRecords(records, MAX_DISPLAY_MODES, count) != OK) {
+        fprintf(stderr, "Unable to list the display modes\n");
+        backend->deinitialize();
+        delete backend;
+        return 1;
+    }
+    printf("%zu display modes\n", count);
+
+    uint64_t allocations = sAllocations;
+    nsecs_t start = systemTime();
+    for (int n = 0; n < iterations; n++) {
+        List<sp<DisplayMode>> modes;
+        backend->getDisplayModes(modes);
+    }
+    report("getDisplayModes", sAllocations - allocations, systemTime() - start, iterations);
+
+    allocations = sAllocations;
+    start = systemTime();
+    for (int n = 0; n < iterations; n++) {
+        backend->getDisplayModeRecords(records, MAX_DISPLAY_MODES, count);
+    }
+    report("getDisplayModeRecords", sAllocations - allocations, systemTime() - start,
+           iterations);
+
+    // LiveDisplay opens the backend on its own
+    backend->deinitialize();
+    delete backend;
+
+    LiveDisplay& ld = LiveDisplay::getInstance();
+    if (!ld.hasFeature(Feature::DISPLAY_MODES)) {
+        fprintf(stderr, "LiveDisplay has no display modes\n");
+        return 1;
+    }
+
+    allocations = sAllocations;
+    start = systemTime();
+    status_t rc = ld.getDisplayModeRecords(records, MAX_DISPLAY_MODES, count);
+    report("LiveDisplay first call", sAllocations - allocations, systemTime() - start, 1);
+    if (rc != OK) {
+        fprintf(stderr, "LiveDisplay was unable to list the display modes\n");
+        return 1;
+    }
+
+    allocations = sAllocations;
+    start = systemTime();
+    for (int n = 0; n < iterations; n++) {
+        ld.getDisplayModeRecords(records, MAX_DISPLAY_MODES, count);
+    }
+    report("LiveDisplay records", sAllocations - allocations, systemTime() - start,
+           iterations);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <utils/Timers.h>
+
+#include "ColorPipeline.h"
+
+/*
+ * Reports ColorPipeline throughput on full frames, on one thread and on
+ * one thread per core.
+ *
+ * usage: livedisplay_pipeline_bench [frames]
+ */
+
+#define DEFAULT_FRAMES 20
+
+using namespace android;
+
+static HSICRanges makeRanges() {
+    HSICRanges ranges;
+    ranges.hue = Range(-180, 180);
+    ranges.saturation = FloatRange(-1.0f, 1.0f);
+    ranges.intensity = FloatRange(-1.0f, 1.0f);
+    ranges.contrast = FloatRange(-1.0f, 1.0f);
+    ranges.saturationThreshold = FloatRange(0.0f, 1.0f);
+    return ranges;
+}
+
+static void fill(std::vector<uint8_t>& buf) {
+    uint32_t seed = 1;
+    for (size_t i = 0; i < buf.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 24;
+    }
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+    if (frames <= 0) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    HSICRanges ranges = makeRanges();
+    ColorPipeline pipeline;
+    pipeline.setPictureAdjustment(HSIC(30, 0.2f, 0.05f, 0.1f, 0.1f), ranges);
+    pipeline.setGains(1.0f, 0.93f, 0.82f);
+
+    const struct {
+        const char* name;
+        uint32_t width, height;
+    } sizes[] = {
+        {"1080p", 1920, 1080},
+        {"1440p", 2560, 1440},
+    };
+    const uint32_t threads[] = {1, 0};
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t width = sizes[i].width;
+        uint32_t height = sizes[i].height;
+        std::vector<uint8_t> src((size_t)width * height * 4);
+        std::vector<uint8_t> dst(src.size());
+        fill(src);
+
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+            if (pipeline.process(src.data(), dst.data(), width, height, width, threads[t]) !=
+                    OK) {
+                fprintf(stderr, "Failed to process a %s frame\n", sizes[i].name);
+                return 1;
+            }
+
+            nsecs_t start = systemTime();
+            for (int n = 0; n < frames; n++) {
+                pipeline.process(src.data(), dst.data(), width, height, width, threads[t]);
+            }
+            double seconds = (systemTime() - start) / 1e9;
+
+            double mpixels = (double)width * height * frames / 1e6;
+            printf("%s, %s: %8.1f MPixel/s, %6.2f ms/frame\n", sizes[i].name,
+                   threads[t] == 1 ? "1 thread" : "all cores", mpixels / seconds,
+                   seconds * 1000.0 / frames);
+        }
+    }
+    return 0;
+}
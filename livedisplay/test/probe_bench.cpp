@@ -0,0 +1,118 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <utils/Timers.h>
+
+#include "BenchUtils.h"
+#include "Parallel.h"
+
+/*
+ * Times a cold feature probe of the backend LiveDisplay would use, one
+ * feature at a time and with every feature probed concurrently, as
+ * LiveDisplay::connect() does when the backend allows it. Each run
+ * happens in a new process on a newly initialized backend.
+ *
+ * usage: livedisplay_probe_bench [runs]
+ */
+
+#define DEFAULT_RUNS 10
+
+using namespace android;
+
+// Same as the probe in LiveDisplay::connect(), with the thread count forced
+static uint32_t probe(LiveDisplayBackend* backend, bool concurrent) {
+    std::vector<Feature> probes;
+    for (uint32_t i = 1; i <= (uint32_t)Feature::MAX; i <<= 1) {
+        probes.push_back(static_cast<Feature>(i));
+    }
+
+    std::atomic<uint32_t> found(0);
+    uint32_t threads = concurrent ? probes.size() : 1;
+    parallelFor(probes.size(), threads, [&](uint32_t, uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; i++) {
+            if (backend->hasFeature(probes[i])) {
+                found |= (uint32_t)probes[i];
+            }
+        }
+    });
+    return found;
+}
+
+// Probe time in ns, or the features found if features is set
+static int64_t coldProbe(bool concurrent, bool features) {
+    LiveDisplayBackend* backend = createBackend();
+    if (backend == NULL || backend->initialize() != OK) {
+        return -1;
+    }
+
+    nsecs_t start = systemTime();
+    uint32_t found = probe(backend, concurrent);
+    nsecs_t elapsed = systemTime() - start;
+
+    backend->deinitialize();
+    delete backend;
+    return features ? found : elapsed;
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : DEFAULT_RUNS;
+    if (runs <= 0) {
+        fprintf(stderr, "usage: %s [runs]\n", argv[0]);
+        return 1;
+    }
+
+    int64_t serialFeatures, concurrentFeatures;
+    if (!runInChild([] { return coldProbe(false, true); }, serialFeatures) ||
+            !runInChild([] { return coldProbe(true, true); }, concurrentFeatures)) {
+        fprintf(stderr, "No LiveDisplay backend on this device\n");
+        return 1;
+    }
+    printf("features 0x%x serial, 0x%x concurrent\n", (uint32_t)serialFeatures,
+           (uint32_t)concurrentFeatures);
+
+    const bool modes[] = {false, true};
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        bool concurrent = modes[m];
+        nsecs_t total = 0, best = 0, worst = 0;
+        for (int n = 0; n < runs; n++) {
+            int64_t elapsed;
+            if (!runInChild([=] { return coldProbe(concurrent, false); }, elapsed)) {
+                fprintf(stderr, "Probe run failed\n");
+                return 1;
+            }
+            total += elapsed;
+            best = n == 0 ? elapsed : std::min(best, (nsecs_t)elapsed);
+            worst = std::max(worst, (nsecs_t)elapsed);
+        }
+        printf("%-10s %8.1f us avg %8.1f us min %8.1f us max (%d runs)\n",
+               concurrent ? "concurrent" : "serial", ns2us(total) / (double)runs,
+               (double)ns2us(best), (double)ns2us(worst), runs);
+    }
+
+    if (serialFeatures != concurrentFeatures) {
+        fprintf(stderr, "Concurrent probe found different features!\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+** Copyright 2016, The CyanogenMod Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <cutils/properties.h>
+
+#include "BenchUtils.h"
+#include "ColorDiff.h"
+#include "SweepDump.h"
+
+/*
+ * Records the ranges the vendor backend reports on this device, and what
+ * it reads back for every setting of a sweep over them, into a dump for
+ * livedisplay_golden_test. Dumps are kept in goldens/ as <platform>.dump
+ * and recorded again on every BSP upgrade.
+ *
+ * usage: livedisplay_vendor_sweep [-s steps] dump
+ */
+
+#define DEFAULT_STEPS 3
+
+using namespace android;
+
+static int sweep(LiveDisplayBackend* backend, uint32_t steps, const char* path) {
+    HSICRanges hsicRanges;
+    Range balanceRange;
+    if (!backend->hasFeature(Feature::PICTURE_ADJUSTMENT) ||
+            !backend->hasFeature(Feature::COLOR_TEMPERATURE) ||
+            backend->getPictureAdjustmentRanges(hsicRanges) != OK ||
+            backend->getColorBalanceRange(balanceRange) != OK) {
+        fprintf(stderr, "Backend has no picture adjustment or color balance\n");
+        return 1;
+    }
+
+    sweep_dump_header h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SWEEP_DUMP_MAGIC;
+    h.version = SWEEP_DUMP_VERSION;
+    h.steps = steps;
+    property_get("ro.board.platform", h.platform, "unknown");
+    fromRanges(hsicRanges, balanceRange, h.ranges);
+
+    ColorSweep colorSweep(toRanges(h.ranges), toBalanceRange(h.ranges), steps);
+    if (colorSweep.size() > 1024 * 1024) {
+        fprintf(stderr, "%u steps makes too many settings\n", steps);
+        return 1;
+    }
+    h.count = colorSweep.size();
+
+    HSIC saved;
+    backend->getPictureAdjustment(saved);
+    int32_t savedBalance = backend->getColorBalance();
+
+    // One setting at a time, the hardware has a single global state
+    std::vector<sweep_readback> readback(h.count);
+    uint32_t failed = 0;
+    colorSweep.run([&](uint32_t i, const HSIC& hsic, int32_t balance) {
+        sweep_readback& r = readback[i];
+        HSIC actual;
+        r.status = backend->setPictureAdjustment(hsic);
+        if (r.status == OK) {
+            r.status = backend->setColorBalance(balance);
+        }
+        if (r.status == OK) {
+            r.status = backend->getPictureAdjustment(actual);
+        }
+        r.hue = actual.hue;
+        r.saturation = actual.saturation;
+        r.intensity = actual.intensity;
+        r.contrast = actual.contrast;
+        r.saturationThreshold = actual.saturationThreshold;
+        r.balance = backend->getColorBalance();
+        return r.status == OK;
+    }, failed, 1);
+
+    backend->setPictureAdjustment(saved);
+    backend->setColorBalance(savedBalance);
+
+    if (!writeSweepDump(path, h, readback)) {
+        return 1;
+    }
+    printf("Recorded %u settings for %s in %s, %u failed\n", h.count, h.platform, path, failed);
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    uint32_t steps = DEFAULT_STEPS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:")) != -1) {
+        switch (opt) {
+            case 's':
+                steps = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s steps] dump\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || steps == 0) {
+        fprintf(stderr, "usage: %s [-s steps] dump\n", argv[0]);
+        return 1;
+    }
+
+    LiveDisplayBackend* backend = createBackend();
+    if (backend == NULL || backend->initialize() != OK) {
+        fprintf(stderr, "No LiveDisplay backend on this device\n");
+        delete backend;
+        return 1;
+    }
+
+    int rc = sweep(backend, steps, argv[optind]);
+
+    backend->deinitialize();
+    delete backend;
+    return rc;
+}